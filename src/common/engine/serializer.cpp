@@ -116,16 +116,17 @@ const char *UnicodeToString(const char *cc)
 
 //==========================================================================
 //
-//
+// The binary format is a more compact encoding of the same data which
+// the reader detects by itself. It is not meant to be read by anything else.
 //
 //==========================================================================
 
-bool FSerializer::OpenWriter(bool pretty)
+bool FSerializer::OpenWriter(bool pretty, bool binary)
 {
 	if (w != nullptr || r != nullptr) return false;
 
 	mErrors = 0;
-	w = new FWriter(pretty);
+	w = new FWriter(pretty, binary);
 	BeginObject(nullptr);
 	return true;
 }
@@ -741,57 +742,31 @@ const char *FSerializer::GetOutput(unsigned *len)
 //==========================================================================
 
 FCompressedBuffer FSerializer::GetCompressedOutput()
+{
+	FCompressedBuffer buff = GetStoredOutput();
+	buff.Compress();
+	return buff;
+}
+
+//==========================================================================
+//
+// Returns a copy of the output without compressing it. The CRC is not
+// calculated, FCompressedBuffer::Compress takes care of that.
+//
+//==========================================================================
+
+FCompressedBuffer FSerializer::GetStoredOutput()
 {
 	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
 	WriteObjects();
 	EndObject();
-	buff.mSize = (unsigned)w->mOutString.GetSize();
-	buff.mZipFlags = 0;
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
-
-	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
-
-	z_stream stream;
-	int err;
-
-	stream.next_in = (Bytef *)w->mOutString.GetString();
-	stream.avail_in = buff.mSize;
-	stream.next_out = (Bytef*)compressbuf;
-	stream.avail_out = buff.mSize;
-	stream.zalloc = (alloc_func)0;
-	stream.zfree = (free_func)0;
-	stream.opaque = (voidpf)0;
-
-	// create output in zip-compatible form as required by FCompressedBuffer
-	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
-	if (err != Z_OK)
-	{
-		goto error;
-	}
-
-	err = deflate(&stream, Z_FINISH);
-	if (err != Z_STREAM_END) 
-	{
-		deflateEnd(&stream);
-		goto error;
-	}
-	buff.mCompressedSize = stream.total_out;
-
-	err = deflateEnd(&stream);
-	if (err == Z_OK)
-	{
-		buff.mBuffer = new char[buff.mCompressedSize];
-		buff.mMethod = METHOD_DEFLATE;
-		memcpy(buff.mBuffer, compressbuf, buff.mCompressedSize);
-		delete[] compressbuf;
-		return buff;
-	}
-
-error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
-	buff.mCompressedSize = buff.mSize;
+	buff.mSize = buff.mCompressedSize = (unsigned)w->mOutString.GetSize();
 	buff.mMethod = METHOD_STORED;
+	buff.mZipFlags = 0;
+	buff.mCRC32 = 0;
+	buff.mBuffer = new char[buff.mSize + 1];
+	memcpy(buff.mBuffer, w->mOutString.GetString(), buff.mSize + 1);
 	return buff;
 }
 
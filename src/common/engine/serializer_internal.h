@@ -11,12 +11,13 @@ struct FJSONObject
 {
 	rapidjson::Value* mObject;
 	rapidjson::Value::MemberIterator mIterator;
+	rapidjson::Value::MemberIterator mNext;		// keys are usually read in the order they were written.
 	int mIndex;
 
 	FJSONObject(rapidjson::Value* v)
 	{
 		mObject = v;
-		if (v->IsObject()) mIterator = v->MemberBegin();
+		if (v->IsObject()) mIterator = mNext = v->MemberBegin();
 		else if (v->IsArray())
 		{
 			mIndex = 0;
@@ -24,6 +25,34 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Binary encoding of the same data a JSON writer would produce.
+// Every value is a tag byte followed by its payload. Integers are stored as
+// varints, and each key's text is only written the first time it appears,
+// later uses refer to it by index.
+//
+//==========================================================================
+
+enum EBinarySaveTag : uint8_t
+{
+	SBIN_NULL,
+	SBIN_FALSE,
+	SBIN_TRUE,
+	SBIN_INT,			// zigzag encoded varint
+	SBIN_UINT,			// varint
+	SBIN_DOUBLE,		// 8 bytes, little endian
+	SBIN_STRING,		// varint length + text
+	SBIN_STARTOBJECT,
+	SBIN_ENDOBJECT,
+	SBIN_STARTARRAY,
+	SBIN_ENDARRAY,
+	SBIN_NEWKEY,		// varint length + text, gets the next key index
+	SBIN_KEY,			// varint key index
+};
+
+static const char BinarySaveMagic[4] = { '\x1b', 'G', 'Z', 'B' };
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -38,14 +67,28 @@ struct FWriter
 
 	Writer *mWriter1;
 	PrettyWriter *mWriter2;
+	bool mBinary;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
 
-	FWriter(bool pretty)
+	// Key table for the binary format. Most keys are string literals so the
+	// address is checked first before looking up the text.
+	TArray<FString> mKeys;
+	TMap<FString, unsigned> mKeyIndex;
+	TMap<const char *, unsigned> mKeyAddress;
+
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		mBinary = binary;
+		if (binary)
+		{
+			mWriter1 = nullptr;
+			mWriter2 = nullptr;
+			memcpy(mOutString.Push(sizeof(BinarySaveMagic)), BinarySaveMagic, sizeof(BinarySaveMagic));
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
 			mWriter2 = nullptr;
@@ -69,96 +112,172 @@ struct FWriter
 		return mInObject.Size() > 0 && mInObject.Last();
 	}
 
+	void PutTag(EBinarySaveTag tag)
+	{
+		mOutString.Put((char)tag);
+	}
+
+	void PutVarint(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mOutString.Put(char((v & 0x7f) | 0x80));
+			v >>= 7;
+		}
+		mOutString.Put(char(v));
+	}
+
+	void PutText(EBinarySaveTag tag, const char *k, size_t len)
+	{
+		PutTag(tag);
+		PutVarint(len);
+		if (len > 0) memcpy(mOutString.Push(len), k, len);
+	}
+
+	void PutInt(int64_t k)
+	{
+		PutTag(SBIN_INT);
+		PutVarint((uint64_t(k) << 1) ^ uint64_t(k >> 63));
+	}
+
+	void PutUint(uint64_t k)
+	{
+		PutTag(SBIN_UINT);
+		PutVarint(k);
+	}
+
+	void PutKey(const char *k)
+	{
+		unsigned *index = mKeyAddress.CheckKey(k);
+		if (index == nullptr || mKeys[*index].Compare(k) != 0)
+		{
+			FString key = k;
+			index = mKeyIndex.CheckKey(key);
+			if (index == nullptr)
+			{
+				unsigned newindex = mKeys.Push(key);
+				mKeyIndex.Insert(key, newindex);
+				mKeyAddress[k] = newindex;
+				PutText(SBIN_NEWKEY, key.GetChars(), key.Len());
+				return;
+			}
+			mKeyAddress[k] = *index;
+		}
+		PutTag(SBIN_KEY);
+		PutVarint(*index);
+	}
+
 	void StartObject()
 	{
-		if (mWriter1) mWriter1->StartObject();
+		if (mBinary) PutTag(SBIN_STARTOBJECT);
+		else if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
 	}
 
 	void EndObject()
 	{
-		if (mWriter1) mWriter1->EndObject();
+		if (mBinary) PutTag(SBIN_ENDOBJECT);
+		else if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
 	}
 
 	void StartArray()
 	{
-		if (mWriter1) mWriter1->StartArray();
+		if (mBinary) PutTag(SBIN_STARTARRAY);
+		else if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
 	}
 
 	void EndArray()
 	{
-		if (mWriter1) mWriter1->EndArray();
+		if (mBinary) PutTag(SBIN_ENDARRAY);
+		else if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
 	}
 
 	void Key(const char *k)
 	{
-		if (mWriter1) mWriter1->Key(k);
+		if (mBinary) PutKey(k);
+		else if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
 	}
 
 	void Null()
 	{
-		if (mWriter1) mWriter1->Null();
+		if (mBinary) PutTag(SBIN_NULL);
+		else if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
 	}
 
 	void StringU(const char *k, bool encode)
 	{
 		if (encode) k = StringToUnicode(k);
-		if (mWriter1) mWriter1->String(k);
+		if (mBinary) PutText(SBIN_STRING, k, strlen(k));
+		else if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
 	}
 
 	void String(const char *k)
 	{
 		k = StringToUnicode(k);
-		if (mWriter1) mWriter1->String(k);
+		if (mBinary) PutText(SBIN_STRING, k, strlen(k));
+		else if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
 	}
 
 	void String(const char *k, int size)
 	{
 		k = StringToUnicode(k, size);
-		if (mWriter1) mWriter1->String(k);
+		if (mBinary) PutText(SBIN_STRING, k, strlen(k));
+		else if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
 	}
 
 	void Bool(bool k)
 	{
-		if (mWriter1) mWriter1->Bool(k);
+		if (mBinary) PutTag(k ? SBIN_TRUE : SBIN_FALSE);
+		else if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
 	}
 
 	void Int(int32_t k)
 	{
-		if (mWriter1) mWriter1->Int(k);
+		if (mBinary) PutInt(k);
+		else if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
 	}
 
 	void Int64(int64_t k)
 	{
-		if (mWriter1) mWriter1->Int64(k);
+		if (mBinary) PutInt(k);
+		else if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
 	}
 
 	void Uint(uint32_t k)
 	{
-		if (mWriter1) mWriter1->Uint(k);
+		if (mBinary) PutUint(k);
+		else if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
 	}
 
 	void Uint64(int64_t k)
 	{
-		if (mWriter1) mWriter1->Uint64(k);
+		if (mBinary) PutUint(uint64_t(k));
+		else if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
 	}
 
 	void Double(double k)
 	{
-		if (mWriter1)
+		if (mBinary)
+		{
+			uint64_t bits;
+			memcpy(&bits, &k, sizeof(bits));
+			PutTag(SBIN_DOUBLE);
+			for (int i = 0; i < 8; i++, bits >>= 8) mOutString.Put(char(bits & 0xff));
+		}
+		else if (mWriter1)
 		{
 			mWriter1->Double(k);
 		}
@@ -176,6 +295,155 @@ struct FWriter
 //
 //==========================================================================
 
+//==========================================================================
+//
+// Turns the binary format back into the SAX events the JSON writer was
+// fed with, so that the reader gets the same document from either.
+//
+//==========================================================================
+
+struct FBinaryReader
+{
+	const uint8_t *mPos;
+	const uint8_t *mEnd;
+	TArray<rapidjson::SizeType> mCounts;	// number of values in each open object or array
+	TArray<std::pair<const char *, rapidjson::SizeType>> mKeys;
+
+	FBinaryReader(const char *buffer, size_t length)
+	{
+		mPos = (const uint8_t *)buffer;
+		mEnd = mPos + length;
+	}
+
+	bool GetVarint(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64 && mPos < mEnd; shift += 7)
+		{
+			uint8_t b = *mPos++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool GetText(const char *&text, rapidjson::SizeType &len)
+	{
+		uint64_t v;
+		if (!GetVarint(v) || v > uint64_t(mEnd - mPos)) return false;
+		text = (const char *)mPos;
+		len = (rapidjson::SizeType)v;
+		mPos += v;
+		return true;
+	}
+
+	void AddValue()
+	{
+		if (mCounts.Size() > 0) mCounts.Last()++;
+	}
+
+	template<class Handler>
+	bool operator()(Handler &h)
+	{
+		const char *text;
+		rapidjson::SizeType len;
+		uint64_t v;
+
+		while (mPos < mEnd)
+		{
+			switch (*mPos++)
+			{
+			case SBIN_NULL:
+				AddValue();
+				h.Null();
+				break;
+
+			case SBIN_FALSE:
+			case SBIN_TRUE:
+				AddValue();
+				h.Bool(mPos[-1] == SBIN_TRUE);
+				break;
+
+			case SBIN_INT:
+				if (!GetVarint(v)) return false;
+				AddValue();
+				h.Int64(int64_t(v >> 1) ^ -int64_t(v & 1));
+				break;
+
+			case SBIN_UINT:
+				if (!GetVarint(v)) return false;
+				AddValue();
+				h.Uint64(v);
+				break;
+
+			case SBIN_DOUBLE:
+			{
+				if (mEnd - mPos < 8) return false;
+				uint64_t bits = 0;
+				for (int i = 7; i >= 0; i--) bits = (bits << 8) | mPos[i];
+				mPos += 8;
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				AddValue();
+				h.Double(d);
+				break;
+			}
+
+			case SBIN_STRING:
+				if (!GetText(text, len)) return false;
+				AddValue();
+				h.String(text, len, true);
+				break;
+
+			case SBIN_NEWKEY:
+				if (!GetText(text, len)) return false;
+				mKeys.Push(std::make_pair(text, len));
+				h.Key(text, len, true);
+				break;
+
+			case SBIN_KEY:
+				if (!GetVarint(v) || v >= mKeys.Size()) return false;
+				h.Key(mKeys[(unsigned)v].first, mKeys[(unsigned)v].second, true);
+				break;
+
+			case SBIN_STARTOBJECT:
+				AddValue();
+				h.StartObject();
+				mCounts.Push(0);
+				break;
+
+			case SBIN_STARTARRAY:
+				AddValue();
+				h.StartArray();
+				mCounts.Push(0);
+				break;
+
+			case SBIN_ENDOBJECT:
+			case SBIN_ENDARRAY:
+			{
+				if (mCounts.Size() == 0) return false;
+				rapidjson::SizeType count;
+				mCounts.Pop(count);
+				if (mPos[-1] == SBIN_ENDOBJECT) h.EndObject(count);
+				else h.EndArray(count);
+				if (mCounts.Size() == 0) return mPos == mEnd;
+				break;
+			}
+
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+};
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 struct FReader
 {
 	TArray<FJSONObject> mObjects;
@@ -186,7 +454,15 @@ struct FReader
 
 	FReader(const char *buffer, size_t length)
 	{
-		mDoc.Parse(buffer, length);
+		if (length >= sizeof(BinarySaveMagic) && !memcmp(buffer, BinarySaveMagic, sizeof(BinarySaveMagic)))
+		{
+			FBinaryReader binary(buffer + sizeof(BinarySaveMagic), length - sizeof(BinarySaveMagic));
+			mDoc.Populate(binary);
+		}
+		else
+		{
+			mDoc.Parse(buffer, length);
+		}
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
@@ -205,9 +481,18 @@ struct FReader
 			}
 			else
 			{
-				// Find the given key by name;
+				// Try the member after the last one found before searching by name.
+				if (obj.mNext != obj.mObject->MemberEnd())
+				{
+					auto &name = obj.mNext->name;
+					if (!strcmp(name.GetString(), key))
+					{
+						return &(obj.mNext++)->value;
+					}
+				}
 				auto it = obj.mObject->FindMember(key);
 				if (it == obj.mObject->MemberEnd()) return nullptr;
+				obj.mNext = it + 1;
 				return &it->value;
 			}
 		}
@@ -40,6 +40,7 @@
 #include "resourcefile.h"
 #include "cmdlib.h"
 #include "printf.h"
+#include "lumpcache.h"
 
 
 
@@ -170,6 +171,7 @@ struct F7ZLump : public FResourceLump
 	int		Position;
 
 	virtual int FillCache();
+	virtual FString GetCacheKey();
 
 };
 
@@ -345,11 +347,43 @@ F7ZFile::~F7ZFile()
 int F7ZLump::FillCache()
 {
 	Cache = new char[LumpSize];
-	static_cast<F7ZFile*>(Owner)->Archive->Extract(Position, Cache);
+
+	FString cachekey;
+	if (UseLumpCache(LumpSize))
+	{
+		cachekey = GetCacheKey();
+		if (cachekey.IsNotEmpty() && ReadCachedLump(cachekey, Cache, LumpSize))
+		{
+			RefCount = 1;
+			return 1;
+		}
+	}
+
+	if (static_cast<F7ZFile*>(Owner)->Archive->Extract(Position, Cache) == SZ_OK && cachekey.IsNotEmpty())
+	{
+		WriteCachedLump(cachekey, Cache, LumpSize);
+	}
 	RefCount = 1;
 	return 1;
 }
 
+//==========================================================================
+//
+// Only files with a stored CRC can be cached.
+//
+//==========================================================================
+
+FString F7ZLump::GetCacheKey()
+{
+	auto &db = static_cast<F7ZFile*>(Owner)->Archive->DB;
+	FString key;
+	if (SzBitWithVals_Check(&db.CRCs, Position))
+	{
+		key.Format("%s-%x-%x-%08x", Owner->GetHash().GetChars(), Position, LumpSize, db.CRCs.Vals[Position]);
+	}
+	return key;
+}
+
 //==========================================================================
 //
 // File open
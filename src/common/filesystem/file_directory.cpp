@@ -234,8 +234,12 @@ void FDirectory::AddEntry(const char *fullpath, int size)
 
 FileReader FDirectoryLump::NewReader()
 {
+	// Mapping a file is only worth it if it is larger than a few pages.
 	FileReader fr;
-	fr.OpenFile(mFullPath);
+	if (LumpSize < 65536 || !fr.OpenMappedFile(mFullPath))
+	{
+		fr.OpenFile(mFullPath);
+	}
 	return fr;
 }
 
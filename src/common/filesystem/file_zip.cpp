@@ -34,6 +34,7 @@
 */
 
 #include <time.h>
+#include <zlib.h>
 #include "file_zip.h"
 #include "cmdlib.h"
 
@@ -41,6 +42,7 @@
 #include "w_zip.h"
 
 #include "ancientzip.h"
+#include "lumpcache.h"
 
 #define BUFREADCOMMENT (0x400)
 
@@ -108,6 +110,60 @@ bool FCompressedBuffer::Decompress(char *destbuffer)
 	return UncompressZipLump(destbuffer, mr, mMethod, mSize, mCompressedSize, mZipFlags);
 }
 
+//==========================================================================
+//
+// Deflates a stored buffer in place. The CRC also gets calculated here so
+// that stored data can be handed off without being looked at first.
+// If compression does not succeed the buffer remains stored.
+//
+//==========================================================================
+
+void FCompressedBuffer::Compress()
+{
+	if (mMethod != METHOD_STORED || mBuffer == nullptr) return;
+
+	mCRC32 = crc32(0, (const Bytef*)mBuffer, mSize);
+
+	uint8_t *compressbuf = new uint8_t[mSize + 1];
+
+	z_stream stream;
+	int err;
+
+	stream.next_in = (Bytef *)mBuffer;
+	stream.avail_in = mSize;
+	stream.next_out = (Bytef*)compressbuf;
+	stream.avail_out = mSize;
+	stream.zalloc = (alloc_func)0;
+	stream.zfree = (free_func)0;
+	stream.opaque = (voidpf)0;
+
+	// create output in zip-compatible form
+	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+	if (err != Z_OK)
+	{
+		delete[] compressbuf;
+		return;
+	}
+
+	err = deflate(&stream, Z_FINISH);
+	if (err != Z_STREAM_END)
+	{
+		deflateEnd(&stream);
+		delete[] compressbuf;
+		return;
+	}
+
+	if (deflateEnd(&stream) == Z_OK)
+	{
+		delete[] mBuffer;
+		mCompressedSize = (unsigned)stream.total_out;
+		mBuffer = new char[mCompressedSize];
+		mMethod = METHOD_DEFLATE;
+		memcpy(mBuffer, compressbuf, mCompressedSize);
+	}
+	delete[] compressbuf;
+}
+
 //-----------------------------------------------------------------------
 //
 // Finds the central directory end record in the end of the file.
@@ -498,21 +554,51 @@ int FZipLump::FillCache()
 	if (NeedFileStart) SetLumpAddress();
 	const char *buffer;
 
-	if (Method == METHOD_STORED && (buffer = Owner->Reader.GetBuffer()) != NULL)
+	if (Method == METHOD_STORED && (buffer = Owner->Reader.GetBuffer()) != NULL && Position + LumpSize <= Owner->Reader.GetLength())
 	{
-		// This is an in-memory file so the cache can point directly to the file's data.
+		// This is an in-memory or mapped file so the cache can point directly to the file's data.
 		Cache = const_cast<char*>(buffer) + Position;
 		RefCount = -1;
 		return -1;
 	}
 
-	Owner->Reader.Seek(Position, FileReader::SeekSet);
 	Cache = new char[LumpSize];
-	UncompressZipLump(Cache, Owner->Reader, Method, LumpSize, CompressedSize, GPFlags);
+
+	FString cachekey;
+	if (Method != METHOD_STORED && UseLumpCache(LumpSize))
+	{
+		cachekey = GetCacheKey();
+		if (ReadCachedLump(cachekey, Cache, LumpSize))
+		{
+			RefCount = 1;
+			return 1;
+		}
+	}
+
+	Owner->Reader.Seek(Position, FileReader::SeekSet);
+	if (UncompressZipLump(Cache, Owner->Reader, Method, LumpSize, CompressedSize, GPFlags) && cachekey.IsNotEmpty())
+	{
+		WriteCachedLump(cachekey, Cache, LumpSize);
+	}
 	RefCount = 1;
 	return 1;
 }
 
+//==========================================================================
+//
+// The CRC covers the uncompressed data so it is enough to tell apart
+// different versions of the same file.
+//
+//==========================================================================
+
+FString FZipLump::GetCacheKey()
+{
+	if (NeedFileStart) SetLumpAddress();
+	FString key;
+	key.Format("%s-%llx-%x-%08x", Owner->GetHash().GetChars(), (unsigned long long)Position, LumpSize, CRC32);
+	return key;
+}
+
 //==========================================================================
 //
 //
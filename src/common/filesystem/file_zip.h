@@ -20,6 +20,7 @@ struct FZipLump : public FResourceLump
 
 	virtual FileReader *GetReader();
 	virtual int FillCache();
+	virtual FString GetCacheKey();
 
 private:
 	void SetLumpAddress();
@@ -39,6 +39,8 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <thread>
+#include <atomic>
 
 #include "m_argv.h"
 #include "cmdlib.h"
@@ -46,6 +48,7 @@
 #include "m_crc32.h"
 #include "printf.h"
 #include "md5.h"
+#include "i_time.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -158,6 +161,31 @@ static void PrintLastError ();
 
 FileSystem fileSystem;
 
+//==========================================================================
+//
+// Runs func for every index on all available cores.
+//
+//==========================================================================
+
+template<class Func>
+static void RunOnAllCores(unsigned count, Func func)
+{
+	std::atomic<unsigned> next(0);
+	auto worker = [&]()
+	{
+		for (unsigned i = next++; i < count; i = next++) func(i);
+	};
+
+	unsigned numthreads = std::min(std::max(std::thread::hardware_concurrency(), 1u), count);
+	TArray<std::thread> threads(numthreads > 0 ? numthreads - 1 : 0);
+	for (unsigned i = 1; i < numthreads; i++)
+	{
+		threads.Push(std::thread(worker));
+	}
+	worker();
+	for (auto &thread : threads) thread.join();
+}
+
 // CODE --------------------------------------------------------------------
 
 FileSystem::FileSystem()
@@ -230,6 +258,7 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 		}
 	}
 
+	uint64_t starttime = I_nsTime();
 	for(unsigned i=0;i<filenames.Size(); i++)
 	{
 		AddFile (filenames[i], nullptr, quiet, filter, hashfile);
@@ -239,6 +268,8 @@ void FileSystem::InitMultipleFiles (TArray<FString> &filenames, bool quiet, Lump
 		MoveLumpsInFolder(path);
 	}
 
+	DPrintf(DMSG_NOTIFY, "Opened %u files in %.2f ms\n", filenames.Size(), (I_nsTime() - starttime) * 1e-6);
+
 	NumEntries = FileInfo.Size();
 	if (NumEntries == 0)
 	{
@@ -310,6 +341,7 @@ int FileSystem::AddFromBuffer(const char* name, const char* type, char* data, in
 
 void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, LumpFilterInfo* filter, FILE* hashfile)
 {
+	uint64_t starttime = I_nsTime();
 	int startlump;
 	bool isdir = false;
 	FileReader filereader;
@@ -329,7 +361,8 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			// Archives are mapped into memory if possible so that uncompressed lumps can be accessed without copying them.
+			if (!filereader.OpenMappedFile(filename) && !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (!quiet)
 				{
@@ -367,6 +400,7 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, bool quiet, L
 		}
 
 		Files.Push(resfile);
+		DPrintf(DMSG_NOTIFY, "%s: added in %.2f ms\n", filename, (I_nsTime() - starttime) * 1e-6);
 
 		for (uint32_t i=0; i < resfile->LumpCount(); i++)
 		{
@@ -879,26 +913,45 @@ void FileSystem::InitHashChains (void)
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
 
+	// Calculating the hashes is the expensive part and can be done in parallel.
+	// The chains are linked in lump order afterward so they are the same as
+	// when done in one pass.
+	enum { HashBlock = 4096 };
+	TArray<uint32_t> keys(NumEntries * 3, true);
+	RunOnAllCores((NumEntries + HashBlock - 1) / HashBlock, [&](unsigned block)
+	{
+		unsigned last = std::min<unsigned>(NumEntries, (block + 1) * HashBlock);
+		for (unsigned k = block * HashBlock; k < last; k++)
+		{
+			keys[k * 3] = LumpNameHash(FileInfo[k].shortName.String) % NumEntries;
+			// Copying the names here would modify their reference counts, which are not thread safe.
+			const FString &longName = FileInfo[k].longName;
+			if (longName.IsNotEmpty())
+			{
+				keys[k * 3 + 1] = MakeKey(longName.GetChars()) % NumEntries;
+
+				auto dot = longName.LastIndexOf('.');
+				auto slash = longName.LastIndexOf('/');
+				keys[k * 3 + 2] = MakeKey(longName.GetChars(), dot > slash ? (size_t)dot : longName.Len()) % NumEntries;
+			}
+		}
+	});
+
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumEntries; i++)
 	{
-		j = LumpNameHash (FileInfo[i].shortName.String) % NumEntries;
+		j = keys[i * 3];
 		NextLumpIndex[i] = FirstLumpIndex[j];
 		FirstLumpIndex[j] = i;
 
 		// Do the same for the full paths
 		if (FileInfo[i].longName.IsNotEmpty())
 		{
-			j = MakeKey(FileInfo[i].longName) % NumEntries;
+			j = keys[i * 3 + 1];
 			NextLumpIndex_FullName[i] = FirstLumpIndex_FullName[j];
 			FirstLumpIndex_FullName[j] = i;
 
-			FString nameNoExt = FileInfo[i].longName;
-			auto dot = nameNoExt.LastIndexOf('.');
-			auto slash = nameNoExt.LastIndexOf('/');
-			if (dot > slash) nameNoExt.Truncate(dot);
-
-			j = MakeKey(nameNoExt) % NumEntries;
+			j = keys[i * 3 + 2];
 			NextLumpIndex_NoExt[i] = FirstLumpIndex_NoExt[j];
 			FirstLumpIndex_NoExt[j] = i;
 
@@ -0,0 +1,411 @@
+/*
+** lumpcache.cpp
+**
+** Persistent on-disk cache for decompressed lumps and decoded images
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Every entry is a separate file in <cache path>/lumps/ named after the
+** MD5 of its key. The file starts with the key itself, the data size and
+** a CRC32 of the data so that collisions and damaged files are detected.
+** The order in which entries were last used is kept in an index file
+** that gets rewritten whenever entries are evicted and at shutdown.
+**
+*/
+
+#include <mutex>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "lumpcache.h"
+#include "files.h"
+#include "cmdlib.h"
+#include "md5.h"
+#include "m_crc32.h"
+#include "i_specialpaths.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "printf.h"
+
+CVAR(Bool, lumpcache, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CUSTOM_CVAR(Int, lumpcache_size, 1024, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 16) self = 16;
+}
+
+static const char LumpCacheMagic[4] = { 'G', 'Z', 'L', 'C' };
+
+enum
+{
+	// Anything smaller is faster to recreate than to look up.
+	MinCachedLumpSize = 16384,
+};
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+class FLumpCache
+{
+	struct Entry
+	{
+		FString Name;
+		uint64_t Size;
+		uint64_t LastUse;
+	};
+
+	std::mutex Mutex;
+	FString Path;
+	TArray<Entry> Entries;
+	TMap<FString, unsigned> Index;
+	uint64_t TotalSize = 0;
+	uint64_t UseCounter = 0;
+	bool Initialized = false;
+	bool Dirty = false;
+
+	void Init();
+	void ReadIndex();
+	void WriteIndex();
+	void Evict(uint64_t limit);
+	void Remove(const FString &name);
+	FString EntryName(const FString &key);
+
+public:
+	~FLumpCache();
+	bool Read(const FString &key, void *buffer, size_t size);
+	void Write(const FString &key, const void *buffer, size_t size);
+	void Clear();
+};
+
+static FLumpCache LumpCache;
+
+//==========================================================================
+//
+// Scans the cache directory. Entries that are not in the index are
+// considered the oldest ones.
+//
+//==========================================================================
+
+void FLumpCache::Init()
+{
+	if (Initialized) return;
+	Initialized = true;
+
+	Path = M_GetCachePath(true);
+	Path << "/lumps/";
+	CreatePath(Path);
+
+	TArray<FFileList> list;
+	ScanDirectory(list, Path);
+	for (auto &file : list)
+	{
+		size_t size;
+		if (file.isDirectory || !GetFileInfo(file.Filename, &size, nullptr)) continue;
+
+		auto name = ExtractFileBase(file.Filename, true);
+		if (name.Len() > 4 && !name.Right(4).CompareNoCase(".tmp"))
+		{
+			// left over from a crash.
+			remove(file.Filename);
+		}
+		else if (name.Len() > 4 && !name.Right(4).CompareNoCase(".lmp"))
+		{
+			Index[name] = Entries.Size();
+			Entries.Push({ name, size, 0 });
+			TotalSize += size;
+		}
+	}
+	ReadIndex();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FLumpCache::ReadIndex()
+{
+	FileReader fr;
+	if (!fr.OpenFile(Path + "index.txt")) return;
+
+	char line[256];
+	if (fr.Gets(line, sizeof(line)) == nullptr) return;
+	UseCounter = strtoull(line, nullptr, 10);
+
+	while (fr.Gets(line, sizeof(line)) != nullptr)
+	{
+		char *space = strchr(line, ' ');
+		if (space == nullptr) continue;
+		*space = 0;
+		auto pEntry = Index.CheckKey(line);
+		if (pEntry != nullptr)
+		{
+			Entries[*pEntry].LastUse = strtoull(space + 1, nullptr, 10);
+		}
+	}
+}
+
+void FLumpCache::WriteIndex()
+{
+	auto fw = FileWriter::Open(Path + "index.txt");
+	if (fw == nullptr) return;
+
+	fw->Printf("%llu\n", (unsigned long long)UseCounter);
+	for (auto &entry : Entries)
+	{
+		fw->Printf("%s %llu\n", entry.Name.GetChars(), (unsigned long long)entry.LastUse);
+	}
+	delete fw;
+	Dirty = false;
+}
+
+FLumpCache::~FLumpCache()
+{
+	if (Dirty) WriteIndex();
+}
+
+//==========================================================================
+//
+// Deletes the least recently used entries until the cache is below the limit
+//
+//==========================================================================
+
+void FLumpCache::Evict(uint64_t limit)
+{
+	std::sort(Entries.begin(), Entries.end(), [](const Entry &a, const Entry &b) { return a.LastUse < b.LastUse; });
+
+	unsigned first = 0;
+	while (first < Entries.Size() && TotalSize > limit)
+	{
+		remove(Path + Entries[first].Name);
+		TotalSize -= Entries[first].Size;
+		first++;
+	}
+	Entries.Delete(0, first);
+
+	Index.Clear();
+	for (unsigned i = 0; i < Entries.Size(); i++)
+	{
+		Index[Entries[i].Name] = i;
+	}
+	WriteIndex();
+}
+
+void FLumpCache::Remove(const FString &name)
+{
+	auto pEntry = Index.CheckKey(name);
+	if (pEntry != nullptr)
+	{
+		// The order of the entries does not matter, so the last one can take its place.
+		unsigned index = *pEntry;
+		TotalSize -= Entries[index].Size;
+		Index.Remove(name);
+		if (index != Entries.Size() - 1)
+		{
+			Entries[index] = std::move(Entries.Last());
+			Index[Entries[index].Name] = index;
+		}
+		Entries.Pop();
+		Dirty = true;
+	}
+	remove(Path + name);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FString FLumpCache::EntryName(const FString &key)
+{
+	MD5Context md5;
+	uint8_t digest[16];
+
+	md5.Update((const uint8_t*)key.GetChars(), (unsigned)key.Len());
+	md5.Final(digest);
+
+	FString name;
+	for (auto c : digest)
+	{
+		name.AppendFormat("%02x", c);
+	}
+	name << ".lmp";
+	return name;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FLumpCache::Read(const FString &key, void *buffer, size_t size)
+{
+	auto name = EntryName(key);
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Init();
+		if (Index.CheckKey(name) == nullptr) return false;
+	}
+
+	bool valid = false;
+	FileReader fr;
+	if (fr.OpenFile(Path + name))
+	{
+		char magic[4];
+		uint32_t keylen = 0;
+		TArray<char> storedkey;
+
+		if (fr.Read(magic, 4) == 4 && !memcmp(magic, LumpCacheMagic, 4) && fr.Read(&keylen, 4) == 4 && keylen == key.Len())
+		{
+			storedkey.Resize(keylen);
+			uint64_t storedsize = 0;
+			uint32_t crc = 0;
+
+			valid = fr.Read(storedkey.Data(), keylen) == keylen && !memcmp(storedkey.Data(), key.GetChars(), keylen) &&
+				fr.Read(&storedsize, 8) == 8 && storedsize == size && fr.Read(&crc, 4) == 4 &&
+				fr.Read(buffer, size) == (FileReader::Size)size && CalcCRC32((const uint8_t*)buffer, (unsigned)size) == crc;
+		}
+		fr.Close();
+	}
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (!valid)
+	{
+		DPrintf(DMSG_WARNING, "Discarding invalid lump cache entry %s\n", name.GetChars());
+		Remove(name);
+		return false;
+	}
+	auto pEntry = Index.CheckKey(name);
+	if (pEntry != nullptr)
+	{
+		Entries[*pEntry].LastUse = ++UseCounter;
+		Dirty = true;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FLumpCache::Write(const FString &key, const void *buffer, size_t size)
+{
+	auto name = EntryName(key);
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		Init();
+	}
+
+	// Write to a temporary file first so that an interrupted write can never leave a damaged entry.
+	FString filename = Path + name;
+	FString tempname = filename + ".tmp";
+	auto fw = FileWriter::Open(tempname);
+	if (fw == nullptr) return;
+
+	uint32_t keylen = (uint32_t)key.Len();
+	uint64_t size64 = size;
+	uint32_t crc = CalcCRC32((const uint8_t*)buffer, (unsigned)size);
+	bool ok = fw->Write(LumpCacheMagic, 4) == 4 && fw->Write(&keylen, 4) == 4 && fw->Write(key.GetChars(), keylen) == keylen &&
+		fw->Write(&size64, 8) == 8 && fw->Write(&crc, 4) == 4 && fw->Write(buffer, size) == size;
+	delete fw;
+
+	remove(filename);
+	if (!ok || rename(tempname, filename) != 0)
+	{
+		remove(tempname);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	uint64_t filesize = 20 + keylen + size;
+	auto pEntry = Index.CheckKey(name);
+	if (pEntry != nullptr)
+	{
+		TotalSize -= Entries[*pEntry].Size;
+		Entries[*pEntry].Size = filesize;
+		Entries[*pEntry].LastUse = ++UseCounter;
+	}
+	else
+	{
+		Index[name] = Entries.Size();
+		Entries.Push({ name, filesize, ++UseCounter });
+	}
+	TotalSize += filesize;
+	Dirty = true;
+
+	uint64_t limit = uint64_t(*lumpcache_size) << 20;
+	if (TotalSize > limit)
+	{
+		// Leave some headroom so that this doesn't have to be done again right away.
+		Evict(limit - limit / 8);
+	}
+}
+
+void FLumpCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	Init();
+	Evict(0);
+	UseCounter = 0;
+	WriteIndex();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool UseLumpCache(size_t size)
+{
+	return lumpcache && size >= MinCachedLumpSize;
+}
+
+bool ReadCachedLump(const FString &key, void *buffer, size_t size)
+{
+	return LumpCache.Read(key, buffer, size);
+}
+
+void WriteCachedLump(const FString &key, const void *buffer, size_t size)
+{
+	LumpCache.Write(key, buffer, size);
+}
+
+UNSAFE_CCMD(clearlumpcache)
+{
+	LumpCache.Clear();
+}
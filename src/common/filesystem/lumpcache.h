@@ -0,0 +1,18 @@
+#ifndef __LUMPCACHE_H
+#define __LUMPCACHE_H
+
+#include <stddef.h>
+
+class FString;
+
+// Optional persistent cache for data that is expensive to recreate from a
+// resource file, like decompressed lumps or decoded images. Entries are
+// addressed by a key that identifies the lump's contents (see
+// FResourceLump::GetCacheKey) and are evicted in LRU order once the cache
+// grows beyond lumpcache_size megabytes.
+
+bool UseLumpCache(size_t size);
+bool ReadCachedLump(const FString &key, void *buffer, size_t size);
+void WriteCachedLump(const FString &key, const void *buffer, size_t size);
+
+#endif
@@ -73,6 +73,7 @@ struct FCompressedBuffer
 	char *mBuffer;
 
 	bool Decompress(char *destbuffer);
+	void Compress();
 	void Clean()
 	{
 		mSize = mCompressedSize = 0;
@@ -112,6 +113,7 @@ public:
 	virtual int GetFileOffset() { return -1; }
 	virtual int GetIndexNum() const { return -1; }
 	virtual int GetNamespace() const { return 0; }
+	virtual FString GetCacheKey() { return FString(); }	// identifies the lump's content for the lump cache. Empty if the content cannot be verified.
 	void LumpNameSetup(FString iname);
 	void CheckEmbedded(LumpFilterInfo* lfi);
 	virtual FCompressedBuffer GetRawData();
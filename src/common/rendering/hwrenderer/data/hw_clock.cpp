@@ -44,6 +44,7 @@
 glcycle_t RenderWall,SetupWall,ClipWall;
 glcycle_t RenderFlat,SetupFlat;
 glcycle_t RenderSprite,SetupSprite;
+glcycle_t SortItems;
 glcycle_t All, Finish, PortalAll, Bsp;
 glcycle_t ProcessAll, PostProcess;
 glcycle_t RenderAll;
@@ -72,6 +73,7 @@ void ResetProfilingData()
 	SetupFlat.Reset();
 	RenderSprite.Reset();
 	SetupSprite.Reset();
+	SortItems.Reset();
 	drawcalls.Reset();
 	MTWait.Reset();
 	WTTotal.Reset();
@@ -96,6 +98,7 @@ static void AppendRenderTimes(FString &str)
 		"W: Render=%2.3f, Setup=%2.3f\n"
 		"F: Render=%2.3f, Setup=%2.3f\n"
 		"S: Render=%2.3f, Setup=%2.3f\n"
+		"Translucent sort=%2.3f\n"
 		"2D: %2.3f Finish3D: %2.3f\n"
 		"Main thread total=%2.3f, Main thread waiting=%2.3f Worker thread total=%2.3f, Worker thread waiting=%2.3f\n"
 		"All=%2.3f, Render=%2.3f, Setup=%2.3f, Portal=%2.3f, Drawcalls=%2.3f, Postprocess=%2.3f, Finish=%2.3f\n",
@@ -103,6 +106,7 @@ static void AppendRenderTimes(FString &str)
 		RenderWall.TimeMS(), setupwall, 
 		RenderFlat.TimeMS(), SetupFlat.TimeMS(),
 		RenderSprite.TimeMS(), SetupSprite.TimeMS(), 
+		SortItems.TimeMS(),
 		twoD.TimeMS(), Flush3D.TimeMS() - twoD.TimeMS(),
 		MTWait.TimeMS() + Bsp.TimeMS(), MTWait.TimeMS(), WTTotal.TimeMS(), WTTotal.TimeMS() - setupwall - SetupFlat.TimeMS() - SetupSprite.TimeMS(),
 		All.TimeMS() + Finish.TimeMS(), RenderAll.TimeMS(),	ProcessAll.TimeMS(), PortalAll.TimeMS(), drawcalls.TimeMS(), PostProcess.TimeMS(), Finish.TimeMS());
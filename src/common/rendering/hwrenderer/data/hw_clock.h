@@ -7,6 +7,7 @@
 extern glcycle_t RenderWall,SetupWall,ClipWall;
 extern glcycle_t RenderFlat,SetupFlat;
 extern glcycle_t RenderSprite,SetupSprite;
+extern glcycle_t SortItems;
 extern glcycle_t All, Finish, PortalAll, Bsp;
 extern glcycle_t ProcessAll, PostProcess;
 extern glcycle_t RenderAll;
@@ -37,6 +37,9 @@
 #include "m_argv.h"
 #include "c_cvars.h"
 #include "jit.h"
+#include "filesystem.h"
+#include "stats.h"
+#include "printf.h"
 
 CVAR(Bool, strictdecorate, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
 
@@ -142,6 +145,7 @@ void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 	func->NumRegS = Registers[REGT_STRING].MostUsed;
 	func->MaxParam = MaxParam;
 	func->StackSize = VMFrame::FrameSize(func->NumRegD, func->NumRegF, func->NumRegS, func->NumRegA, func->MaxParam, func->ExtraSpace);
+	func->ClassifyConstReturn();
 
 	// Technically, there's no reason why we can't end the function with
 	// entries on the parameter stack, but it means the caller probably
@@ -752,6 +756,53 @@ void VMFunctionBuilder::BackpatchListToHere(TArray<size_t> &locs)
 		Backpatch(loc, Code.Size());
 }
 
+//==========================================================================
+//
+// -zscripttimings
+//
+//==========================================================================
+
+struct FScriptTiming
+{
+	double Time[NUM_SCRIPTTIMINGPHASES] = {};
+	int NumFunctions = 0;
+};
+
+static TMap<int, FScriptTiming> ScriptTimings;
+
+void AddScriptTime(int lump, EScriptTimingPhase phase, double ms)
+{
+	auto &timing = ScriptTimings[lump];
+	timing.Time[phase] += ms;
+	if (phase == STP_CodeGen) timing.NumFunctions++;
+}
+
+static void PrintScriptTimings()
+{
+	TArray<int> lumps;
+	decltype(ScriptTimings)::Iterator it(ScriptTimings);
+	decltype(ScriptTimings)::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		lumps.Push(pair->Key);
+	}
+	std::sort(lumps.begin(), lumps.end());
+
+	// The JIT times are the sum over all worker threads, not wall clock time.
+	FScriptTiming total;
+	Printf("%-48s %9s %9s %9s %9s %6s\n", "File", "Parse", "Compile", "CodeGen", "JIT", "Funcs");
+	for (auto lump : lumps)
+	{
+		auto &timing = *ScriptTimings.CheckKey(lump);
+		Printf("%-48s %9.2f %9.2f %9.2f %9.2f %6d\n", lump >= 0 ? fileSystem.GetFileFullPath(lump).GetChars() : "<unknown>",
+			timing.Time[STP_Parse], timing.Time[STP_Compile], timing.Time[STP_CodeGen], timing.Time[STP_JIT], timing.NumFunctions);
+		for (int i = 0; i < NUM_SCRIPTTIMINGPHASES; i++) total.Time[i] += timing.Time[i];
+		total.NumFunctions += timing.NumFunctions;
+	}
+	Printf("%-48s %9.2f %9.2f %9.2f %9.2f %6d\n", "Total",
+		total.Time[STP_Parse], total.Time[STP_Compile], total.Time[STP_CodeGen], total.Time[STP_JIT], total.NumFunctions);
+}
+
 //==========================================================================
 //
 // FFunctionBuildList
@@ -816,6 +867,8 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 void FFunctionBuildList::Build()
 {
 	VMDisassemblyDumper disasmdump(VMDisassemblyDumper::Overwrite);
+	TArray<VMScriptFunction *> built;
+	TArray<int> builtlumps;
 
 	for (auto &item : mItems)
 	{
@@ -823,6 +876,10 @@ void FFunctionBuildList::Build()
 		bool isAbstract = item.Func->Variants[0].Implementation->VarFlags & VARF_Abstract;
 		if (isAbstract) continue;
 
+		cycle_t codegentime;
+		codegentime.Reset();
+		codegentime.Clock();
+
 		assert(item.Code != NULL);
 
 		// We don't know the return type in advance for anonymous functions.
@@ -909,6 +966,8 @@ void FFunctionBuildList::Build()
 				disasmdump.Write(sfunc, item.PrintableName);
 
 				sfunc->Unsafe = ctx.Unsafe;
+				built.Push(sfunc);
+				builtlumps.Push(item.Lump);
 			}
 			catch (CRecoverableError &err)
 			{
@@ -918,11 +977,28 @@ void FFunctionBuildList::Build()
 		}
 		delete item.Code;
 		disasmdump.Flush();
+		codegentime.Unclock();
+		AddScriptTime(item.Lump, STP_CodeGen, codegentime.TimeMS());
 	}
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = strictdecorate;
 
 	if (FScriptPosition::ErrorCounter == 0 && Args->CheckParm("-dumpjit")) DumpJit();
+
+	// Everything the JIT compiler needs is set up now so the functions can be compiled while the startup continues.
+	if (FScriptPosition::ErrorCounter == 0) JitPrecompile(built);
+
+	if (Args->CheckParm("-zscripttimings"))
+	{
+		TArray<double> jittimes;
+		JitFinishPrecompile(&jittimes);
+		for (unsigned i = 0; i < jittimes.Size(); i++)
+		{
+			AddScriptTime(builtlumps[i], STP_JIT, jittimes[i]);
+		}
+		PrintScriptTimings();
+	}
+	ScriptTimings.Clear();
 	mItems.Clear();
 	mItems.ShrinkToFit();
 	FxAlloc.FreeAllBlocks();
@@ -164,6 +164,18 @@ public:
 
 extern FFunctionBuildList FunctionBuildList;
 
+// Per file compile times, printed at the end of FFunctionBuildList::Build with -zscripttimings.
+enum EScriptTimingPhase
+{
+	STP_Parse,
+	STP_Compile,
+	STP_CodeGen,
+	STP_JIT,
+	NUM_SCRIPTTIMINGPHASES
+};
+
+void AddScriptTime(int lump, EScriptTimingPhase phase, double ms);
+
 
 //==========================================================================
 //
@@ -1,7 +1,9 @@
 
+#include <thread>
 #include "jit.h"
 #include "jitintern.h"
 #include "printf.h"
+#include "c_cvars.h"
 
 extern PString *TypeString;
 extern PStruct *TypeVector2;
@@ -12,7 +14,10 @@ extern PStruct* TypeFQuaternion;
 
 static void OutputJitLog(const asmjit::StringLogger &logger);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+EXTERN_CVAR(Bool, vm_jit)
+CVAR(Bool, vm_jit_precompile, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, bool reporterrors)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName.GetChars(), "StatusScreen.drawNum") != 0)
@@ -34,12 +39,142 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
-		OutputJitLog(logger);
-		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
+		if (reporterrors)
+		{
+			OutputJitLog(logger);
+			Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
+		}
 		return nullptr;
 	}
 }
 
+//==========================================================================
+//
+// Background compiler
+//
+// Compiles a list of freshly built functions on worker threads so that
+// FirstScriptCall will find most of them already done. Which thread compiles
+// a function does not affect the generated code and the workers never print
+// anything, so the output stays the same as with on-demand compilation.
+//
+//==========================================================================
+
+static struct FJitPrecompiler
+{
+	TArray<VMScriptFunction *> Functions;
+	TArray<double> Times;
+	TArray<std::thread> Threads;
+	std::atomic<unsigned> Next { 0 };
+	std::atomic<bool> Cancel { false };
+
+	~FJitPrecompiler()
+	{
+		Stop();
+	}
+
+	void Work()
+	{
+		unsigned index;
+		while (!Cancel && (index = Next++) < Functions.Size())
+		{
+			auto sfunc = Functions[index];
+			// FirstScriptCall will not use code for functions over the register limit and prints the warning for them.
+			if (JitRegisterCount(sfunc) >= JIT_MAX_REGS) continue;
+
+			uint8_t state = JIT_Pending;
+			if (!sfunc->JitState.compare_exchange_strong(state, JIT_Compiling)) continue;
+
+			cycle_t time;
+			time.Reset();
+			time.Clock();
+			try
+			{
+				sfunc->JitCode = JitCompile(sfunc, false);
+			}
+			catch (...)
+			{
+				// FirstScriptCall will try again and report the error.
+				sfunc->JitCode = nullptr;
+			}
+			time.Unclock();
+			Times[index] = time.TimeMS();
+			sfunc->JitState.store(JIT_Done, std::memory_order_release);
+		}
+	}
+
+	void Start(const TArray<VMScriptFunction *> &functions)
+	{
+		Wait();
+		Functions = functions;
+		Times.Resize(Functions.Size());
+		for (auto &t : Times) t = 0;
+		Next = 0;
+		Cancel = false;
+
+		// Leave one core for the main thread, which continues with the startup.
+		unsigned numthreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		for (unsigned i = 0; i < numthreads; i++)
+		{
+			Threads.Push(std::thread([this]() { Work(); }));
+		}
+	}
+
+	void Wait()
+	{
+		for (auto &thread : Threads) thread.join();
+		Threads.Clear();
+	}
+
+	void Stop()
+	{
+		Cancel = true;
+		Wait();
+		Functions.Clear();
+	}
+} Precompiler;
+
+void JitPrecompile(const TArray<VMScriptFunction *> &functions)
+{
+	if (vm_jit && vm_jit_precompile && functions.Size() > 0)
+	{
+		Precompiler.Start(functions);
+	}
+}
+
+// Waits for the background compiler and optionally returns the time spent
+// on each function in the list that was passed to JitPrecompile.
+void JitFinishPrecompile(TArray<double> *times)
+{
+	Precompiler.Wait();
+	if (times)
+	{
+		if (Precompiler.Times.Size() == Precompiler.Functions.Size()) *times = Precompiler.Times;
+		else times->Clear();
+	}
+}
+
+void JitStopPrecompile()
+{
+	Precompiler.Stop();
+}
+
+// Called by FirstScriptCall. Returns true if the background compiler has
+// compiled the function, waiting for it if it is currently working on it.
+// Otherwise the function gets marked so that the background compiler skips it.
+bool JitTakePrecompiled(VMScriptFunction *sfunc, JitFuncPtr &code)
+{
+	uint8_t state = JIT_Pending;
+	if (sfunc->JitState.compare_exchange_strong(state, JIT_Done)) return false;
+
+	while (state == JIT_Compiling)
+	{
+		std::this_thread::yield();
+		state = sfunc->JitState.load(std::memory_order_acquire);
+	}
+	code = sfunc->JitCode;
+	return true;
+}
+
 void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
@@ -127,10 +262,10 @@ asmjit::CCFunc *JitCompiler::Codegen()
 
 		if (op != OP_PARAM && op != OP_PARAMI && op != OP_VTBL)
 		{
-			FString lineinfo;
-			lineinfo.Format("; line %d: %02x%02x%02x%02x %s", curLine, pc->op, pc->a, pc->b, pc->c, OpNames[op]);
+			char lineinfo[64];
+			int len = snprintf(lineinfo, sizeof(lineinfo), "; line %d: %02x%02x%02x%02x %s", curLine, pc->op, pc->a, pc->b, pc->c, OpNames[op]);
 			cc.comment("", 0);
-			cc.comment(lineinfo.GetChars(), lineinfo.Len());
+			cc.comment(lineinfo, std::min<size_t>(len, sizeof(lineinfo) - 1));
 		}
 
 		labels[i].cursor = cc.getCursor();
@@ -236,9 +371,10 @@ void JitCompiler::Setup()
 	cc.comment("", 0);
 	cc.comment(marks, 56);
 
-	FString funcname;
-	funcname.Format("Function: %s", sfunc->PrintableName.GetChars());
-	cc.comment(funcname.GetChars(), funcname.Len());
+	// This runs on the background compiler's threads, which must not create any FStrings.
+	std::string funcname = "Function: ";
+	funcname += sfunc->PrintableName.GetChars();
+	cc.comment(funcname.c_str(), funcname.length());
 
 	cc.comment(marks, 56);
 	cc.comment("", 0);
@@ -448,26 +584,26 @@ void JitCompiler::CreateRegisters()
 
 	for (int i = 0; i < sfunc->NumRegD; i++)
 	{
-		regname.Format("regD%d", i);
-		regD[i] = cc.newInt32(regname.GetChars());
+		snprintf(regname, sizeof(regname), "regD%d", i);
+		regD[i] = cc.newInt32(regname);
 	}
 
 	for (int i = 0; i < sfunc->NumRegF; i++)
 	{
-		regname.Format("regF%d", i);
-		regF[i] = cc.newXmmSd(regname.GetChars());
+		snprintf(regname, sizeof(regname), "regF%d", i);
+		regF[i] = cc.newXmmSd(regname);
 	}
 
 	for (int i = 0; i < sfunc->NumRegS; i++)
 	{
-		regname.Format("regS%d", i);
-		regS[i] = cc.newIntPtr(regname.GetChars());
+		snprintf(regname, sizeof(regname), "regS%d", i);
+		regS[i] = cc.newIntPtr(regname);
 	}
 
 	for (int i = 0; i < sfunc->NumRegA; i++)
 	{
-		regname.Format("regA%d", i);
-		regA[i] = cc.newIntPtr(regname.GetChars());
+		snprintf(regname, sizeof(regname), "regA%d", i);
+		regA[i] = cc.newIntPtr(regname);
 	}
 }
 
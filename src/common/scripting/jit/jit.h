@@ -3,6 +3,15 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+JitFuncPtr JitCompile(VMScriptFunction *func, bool reporterrors = true);
+bool JitTakePrecompiled(VMScriptFunction *func, JitFuncPtr &code);
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int maxFrames = -1);
+
+// Asmjit has a 256 register limit. Stay safely away from it as the jit compiler uses a few for temporaries as well.
+enum { JIT_MAX_REGS = 200 };
+
+inline int JitRegisterCount(const VMScriptFunction *func)
+{
+	return func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS;
+}
@@ -2,6 +2,7 @@
 #include "jitintern.h"
 #include <map>
 #include <memory>
+#include <mutex>
 
 void JitCompiler::EmitPARAM()
 {
@@ -81,6 +82,51 @@ void JitCompiler::EmitVMCall(asmjit::X86Gp vmfunc, VMFunction *target)
 	if (pc > sfunc->Code && (pc - 1)->op == OP_VTBL)
 		EmitVtbl(pc - 1);
 
+	// Calls to functions that only return a constant are replaced by their result.
+	// If the target is only known at run time this is guarded by a check of its ConstReturnKind.
+	int retkind;
+	bool guarded = false;
+	Label L_done;
+	if (GetConstReturnKind(pc + 1, C, retkind))
+	{
+		if (target != nullptr)
+		{
+			if (target->ConstReturnKind != VMCONSTRET_None && (retkind == VMCONSTRET_None || target->ConstReturnKind == retkind))
+			{
+				if (retkind == VMCONSTRET_Int)
+					cc.mov(regD[pc[1].c], target->ConstReturnInt);
+				else if (retkind == VMCONSTRET_Float)
+					cc.movsd(regF[pc[1].c], cc.newDoubleConst(kConstScopeLocal, target->ConstReturnFloat));
+				ParamOpcodes.Clear();
+				return;
+			}
+		}
+		else
+		{
+			guarded = true;
+			L_done = cc.newLabel();
+			Label L_call = cc.newLabel();
+			X86Gp kind = newTempInt32();
+			cc.movzx(kind, x86::byte_ptr(vmfunc, myoffsetof(VMFunction, ConstReturnKind)));
+			if (retkind == VMCONSTRET_None)
+			{
+				cc.test(kind, kind);
+				cc.jz(L_call);
+			}
+			else
+			{
+				cc.cmp(kind, retkind);
+				cc.jne(L_call);
+				if (retkind == VMCONSTRET_Int)
+					cc.mov(regD[pc[1].c], x86::dword_ptr(vmfunc, myoffsetof(VMFunction, ConstReturnInt)));
+				else
+					cc.movsd(regF[pc[1].c], x86::qword_ptr(vmfunc, myoffsetof(VMFunction, ConstReturnFloat)));
+			}
+			cc.jmp(L_done);
+			cc.bind(L_call);
+		}
+	}
+
 	FillReturns(pc + 1, C);
 
 	X86Gp paramsptr = newTempIntPtr();
@@ -102,9 +148,37 @@ void JitCompiler::EmitVMCall(asmjit::X86Gp vmfunc, VMFunction *target)
 	LoadInOuts();
 	LoadReturns(pc + 1, C);
 
+	if (guarded)
+		cc.bind(L_done);
+
 	ParamOpcodes.Clear();
 }
 
+// Checks if the results of a call can be provided by one of the functions VMCallConstReturn handles.
+// kind receives the ConstReturnKind the target needs to have, VMCONSTRET_None meaning any.
+bool JitCompiler::GetConstReturnKind(const VMOP *retval, int numret, int &kind)
+{
+	if (numret == 0)
+	{
+		kind = VMCONSTRET_None;
+		return true;
+	}
+	if (numret == 1 && retval->op == OP_RESULT)
+	{
+		if (retval->b == REGT_INT)
+		{
+			kind = VMCONSTRET_Int;
+			return true;
+		}
+		if (retval->b == REGT_FLOAT)
+		{
+			kind = VMCONSTRET_Float;
+			return true;
+		}
+	}
+	return false;
+}
+
 int JitCompiler::StoreCallParams()
 {
 	using namespace asmjit;
@@ -589,14 +663,15 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 	ParamOpcodes.Clear();
 }
 
-static std::map<FString, std::unique_ptr<TArray<uint8_t>>> argsCache;
+static std::map<std::string, std::unique_ptr<TArray<uint8_t>>> argsCache;
+static std::mutex argsCacheMutex;
 
 asmjit::FuncSignature JitCompiler::CreateFuncSignature()
 {
 	using namespace asmjit;
 
 	TArray<uint8_t> args;
-	FString key;
+	std::string key;
 
 	// First add parameters as args to the signature
 
@@ -712,6 +787,7 @@ asmjit::FuncSignature JitCompiler::CreateFuncSignature()
 	}
 
 	// FuncSignature only keeps a pointer to its args array. Store a copy of each args array variant.
+	std::lock_guard<std::mutex> lock(argsCacheMutex);
 	std::unique_ptr<TArray<uint8_t>> &cachedArgs = argsCache[key];
 	if (!cachedArgs) cachedArgs.reset(new TArray<uint8_t>(args));
 
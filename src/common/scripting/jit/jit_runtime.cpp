@@ -1,5 +1,8 @@
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "jit.h"
 #include "jitintern.h"
 
@@ -16,30 +19,31 @@
 
 struct JitFuncInfo
 {
-	FString name;
-	FString filename;
+	// No FStrings here because the worker threads of the background compiler add to this.
+	std::string name;
+	std::string filename;
 	TArray<JitLineInfo> LineInfo;
 	void *start;
 	void *end;
 };
 
-static TArray<JitFuncInfo> JitDebugInfo;
+static std::vector<JitFuncInfo> JitDebugInfo;
 static TArray<uint8_t*> JitBlocks;
 static TArray<uint8_t*> JitFrames;
 static size_t JitBlockPos = 0;
 static size_t JitBlockSize = 0;
 
+// Functions can be compiled by the background compiler's worker threads, so the
+// code memory and the debug info must be protected.
+static std::mutex JitMutex;
+
 asmjit::CodeInfo GetHostCodeInfo()
 {
-	static bool firstCall = true;
-	static asmjit::CodeInfo codeInfo;
-
-	if (firstCall)
+	static const asmjit::CodeInfo codeInfo = []()
 	{
 		asmjit::JitRuntime rt;
-		codeInfo = rt.getCodeInfo();
-		firstCall = false;
-	}
+		return rt.getCodeInfo();
+	}();
 
 	return codeInfo;
 }
@@ -274,6 +278,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	codeSize = (codeSize + 15) / 16 * 16;
 
+	std::lock_guard<std::mutex> lock(JitMutex);
 	uint8_t *p = (uint8_t *)AllocJitMemory(codeSize + unwindInfoSize + functionTableSize);
 	if (!p)
 		return nullptr;
@@ -306,7 +311,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// The names are copied so that no reference counts of strings the main thread may be using get touched.
+	JitDebugInfo.push_back({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -665,6 +671,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	codeSize = (codeSize + 15) / 16 * 16;
 
+	std::lock_guard<std::mutex> lock(JitMutex);
 	uint8_t *p = (uint8_t *)AllocJitMemory(codeSize + unwindInfoSize);
 	if (!p)
 		return nullptr;
@@ -730,7 +737,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// The names are copied so that no reference counts of strings the main thread may be using get touched.
+	JitDebugInfo.push_back({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 
 	return p;
 }
@@ -738,6 +746,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	std::lock_guard<std::mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -753,7 +762,7 @@ void JitRelease()
 	{
 		asmjit::OSUtils::releaseVirtualMemory(p, 1024 * 1024);
 	}
-	JitDebugInfo.Clear();
+	JitDebugInfo.clear();
 	JitFrames.Clear();
 	JitBlocks.Clear();
 	JitBlockPos = 0;
@@ -945,7 +954,8 @@ int JITPCToLine(uint8_t *pc, const JitFuncInfo *info)
 
 FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 {
-	for (unsigned int i = 0; i < JitDebugInfo.Size(); i++)
+	std::lock_guard<std::mutex> lock(JitMutex);
+	for (unsigned int i = 0; i < JitDebugInfo.size(); i++)
 	{
 		const auto &info = JitDebugInfo[i];
 		if (pc >= info.start && pc < info.end)
@@ -955,9 +965,9 @@ FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 			FString s;
 
 			if (line == -1)
-				s.Format("Called from %s at %s\n", info.name.GetChars(), info.filename.GetChars());
+				s.Format("Called from %s at %s\n", info.name.c_str(), info.filename.c_str());
 			else
-				s.Format("Called from %s at %s, line %d\n", info.name.GetChars(), info.filename.GetChars(), line);
+				s.Format("Called from %s at %s, line %d\n", info.name.c_str(), info.filename.c_str(), line);
 
 			return s;
 		}
@@ -12,6 +12,7 @@
 #include <asmjit/x86.h>
 #include <functional>
 #include <vector>
+#include <string>
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
@@ -63,6 +64,7 @@ private:
 	void EmitNativeCall(VMNativeFunction *target);
 	void EmitVMCall(asmjit::X86Gp ptr, VMFunction *target);
 	void EmitVtbl(const VMOP *op);
+	bool GetConstReturnKind(const VMOP *retval, int numret, int &kind);
 
 	int StoreCallParams();
 	void LoadInOuts();
@@ -194,7 +196,7 @@ private:
 	template<typename RetType, typename P1, typename P2, typename P3, typename P4, typename P5, typename P6, typename P7, typename P8, typename P9>
 	asmjit::CCFuncCall* CreateCall(RetType(*func)(P1 p1, P2 p2, P3 p3, P4 p4, P5 p5, P6 p6, P7 p7, P8 p8, P9 p9)) { return cc.call(asmjit::imm_ptr(reinterpret_cast<void*>(static_cast<RetType(*)(P1, P2, P3, P4, P5, P6, P7, P8, P9)>(func))), asmjit::FuncSignature9<RetType, P1, P2, P3, P4, P5, P6, P7, P8, P9>()); }
 
-	FString regname;
+	char regname[32];
 	size_t tmpPosInt32, tmpPosInt64, tmpPosIntPtr, tmpPosXmmSd, tmpPosXmmSs, tmpPosXmmPd, resultPosInt32, resultPosIntPtr, resultPosXmmSd;
 	std::vector<asmjit::X86Gp> regTmpInt32, regTmpInt64, regTmpIntPtr, regResultInt32, regResultIntPtr;
 	std::vector<asmjit::X86Xmm> regTmpXmmSd, regTmpXmmSs, regTmpXmmPd, regResultXmmSd;
@@ -217,8 +219,8 @@ private:
 	{
 		if (tmpPos == tmpVector.size())
 		{
-			regname.Format("%s%d", name, (int)tmpVector.size());
-			tmpVector.push_back(newCallback(regname.GetChars()));
+			snprintf(regname, sizeof(regname), "%s%d", name, (int)tmpVector.size());
+			tmpVector.push_back(newCallback(regname));
 		}
 		return tmpVector[tmpPos++];
 	}
@@ -337,11 +339,11 @@ public:
 
 	const char* what() const noexcept override
 	{
-		return message.GetChars();
+		return message.c_str();
 	}
 
 	asmjit::Error error;
-	FString message;
+	std::string message;
 };
 
 class ThrowingErrorHandler : public asmjit::ErrorHandler
@@ -56,6 +56,9 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void JitPrecompile(const TArray<VMScriptFunction *> &functions);
+void JitFinishPrecompile(TArray<double> *times = nullptr);
+void JitStopPrecompile();
 
 extern void (*VM_CastSpriteIDToString)(FString* a, unsigned int b);
 
@@ -434,6 +437,16 @@ struct VMValue
 	}
 };
 
+// Script functions whose body is nothing but a single return. Calls to them
+// can be replaced by their result without setting up a frame.
+enum EVMConstReturn
+{
+	VMCONSTRET_None,
+	VMCONSTRET_Empty,		// RET with no value
+	VMCONSTRET_Int,			// returns ConstReturnInt
+	VMCONSTRET_Float,		// returns ConstReturnFloat
+};
+
 class VMFunction
 {
 public:
@@ -451,6 +464,11 @@ public:
 
 	int(*ScriptCall)(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret) = nullptr;
 
+	// These are part of the base class so that a virtual call site can check them without knowing whether the target is native.
+	uint8_t ConstReturnKind = VMCONSTRET_None;
+	int ConstReturnInt = 0;
+	double ConstReturnFloat = 0;
+
 	VMFunction(FName name = NAME_None) : ImplicitArgs(0), Name(name), Proto(NULL)
 	{
 		AllFunctions.Push(this);
@@ -466,6 +484,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// the background compiler must not work on any of these anymore.
+		JitStopPrecompile();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
@@ -0,0 +1,225 @@
+/*
+** vmbench.cpp
+**
+** Micro-benchmark for the VM interpreter's dispatch
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The kernels are hand assembled loops of the code the compiler emits for
+** typical actor functions: flag and field checks as produced by
+** FxExpression::EmitCompare, and calls to native functions with a mix of
+** register and constant parameters. They are always run by the interpreter,
+** never by the JIT.
+**
+*/
+
+#include "vmintern.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "printf.h"
+
+extern const char *VMDispatchMode;
+int VMSetSuperOps(bool enable);
+
+struct FBenchActor
+{
+	uint8_t Flags;		// 0
+	int Health;			// 4
+	void *Target;		// 8
+};
+
+static VMOP MakeOp(int op, int a, int b, int c)
+{
+	VMOP o;
+	o.word = 0;
+	o.op = op;
+	o.a = a;
+	o.b = b;
+	o.c = c;
+	return o;
+}
+
+// Offsets are relative to the instruction after the jump, as in the interpreter.
+static VMOP MakeJmp(int from, int to)
+{
+	VMOP o;
+	o.word = 0;
+	o.op = OP_JMP;
+	o.i24 = to - from - 1;
+	return o;
+}
+
+static int BenchNative(VM_ARGS)
+{
+	auto actor = (FBenchActor *)param[0].a;
+	if (numret > 0) ret->SetInt(actor->Health + param[1].i + param[2].i);
+	return numret > 0;
+}
+
+//==========================================================================
+//
+// All kernels take the actor in a0 and the loop count in d0 and return the
+// accumulated d2.
+//
+//==========================================================================
+
+static VMScriptFunction *MakeKernel(const char *name, const TArray<VMOP> &code, const TArray<int> &konstd, const TArray<void *> &konsta, int numregd, int numrega, int maxparam)
+{
+	static const uint8_t regtypes[] = { REGT_POINTER, REGT_INT };
+
+	auto func = new VMScriptFunction(name);
+	func->Alloc(code.Size(), konstd.Size(), 0, 0, konsta.Size(), 0);
+	memcpy(func->Code, code.Data(), code.Size() * sizeof(VMOP));
+	for (unsigned i = 0; i < konstd.Size(); i++) func->KonstD[i] = konstd[i];
+	for (unsigned i = 0; i < konsta.Size(); i++) func->KonstA[i].v = konsta[i];
+	func->NumRegD = numregd;
+	func->NumRegA = numrega;
+	func->MaxParam = maxparam;
+	func->NumArgs = 2;
+	func->RegTypes = regtypes;
+	func->PrintableName = name;
+	func->StackSize = VMFrame::FrameSize(func->NumRegD, func->NumRegF, func->NumRegS, func->NumRegA, func->MaxParam, func->ExtraSpace);
+	func->ScriptCall = VMExec;
+	return func;
+}
+
+static VMScriptFunction *MakeFieldTestKernel()
+{
+	TArray<VMOP> code;
+	code.Push(MakeOp(OP_LI, 2, 0, 0));							// 0: d2 = 0
+	code.Push(MakeOp(OP_LBIT, 1, 0, 1));						// 1: d1 = bFlag
+	code.Push(MakeOp(OP_EQ_K, CMP_CHECK, 1, 0));				// 2: if (d1 == 0) goto 5
+	code.Push(MakeJmp(3, 5));
+	code.Push(MakeOp(OP_ADDI, 2, 2, 1));						// 4: d2++
+	code.Push(MakeOp(OP_LW, 1, 0, 1));							// 5: d1 = Health
+	code.Push(MakeOp(OP_LE_RK, CMP_CHECK, 1, 0));				// 6: if (d1 <= 0) goto 9
+	code.Push(MakeJmp(7, 9));
+	code.Push(MakeOp(OP_ADDI, 2, 2, 1));						// 8: d2++
+	code.Push(MakeOp(OP_LP, 1, 0, 2));							// 9: a1 = Target
+	code.Push(MakeOp(OP_EQA_K, CMP_CHECK, 1, 0));				// 10: if (a1 == nullptr) goto 13
+	code.Push(MakeJmp(11, 13));
+	code.Push(MakeOp(OP_ADDI, 2, 2, 1));						// 12: d2++
+	code.Push(MakeOp(OP_ADDI, 0, 0, 0xff));						// 13: d0--
+	code.Push(MakeOp(OP_LT_KR, CMP_CHECK, 0, 0));				// 14: if (0 < d0) goto 1
+	code.Push(MakeJmp(15, 1));
+	code.Push(MakeOp(OP_RET, RET_FINAL, REGT_INT, 2));			// 16: return d2
+
+	TArray<int> konstd;
+	konstd.Push(0);
+	konstd.Push(4);
+	konstd.Push(8);
+	TArray<void *> konsta;
+	konsta.Push(nullptr);
+	return MakeKernel("VMBench.FieldTests", code, konstd, konsta, 3, 2, 0);
+}
+
+static VMScriptFunction *MakeNativeCallKernel()
+{
+	auto native = new VMNativeFunction(BenchNative, "VMBench.Native");
+
+	TArray<VMOP> code;
+	code.Push(MakeOp(OP_LI, 2, 0, 0));							// 0: d2 = 0
+	code.Push(MakeOp(OP_PARAM, REGT_POINTER, 0, 0));			// 1: Native(a0, d0, 4)
+	code.Push(MakeOp(OP_PARAM, REGT_INT, 0, 0));
+	code.Push(MakeOp(OP_PARAM, REGT_INT | REGT_KONST, 1, 0));
+	code.Push(MakeOp(OP_CALL_K, 1, 3, 1));
+	code.Push(MakeOp(OP_RESULT, 0, REGT_INT, 1));				// 5: -> d1
+	code.Push(MakeOp(OP_ADD_RR, 2, 2, 1));						// 6: d2 += d1
+	code.Push(MakeOp(OP_ADDI, 0, 0, 0xff));						// 7: d0--
+	code.Push(MakeOp(OP_LT_KR, CMP_CHECK, 0, 0));				// 8: if (0 < d0) goto 1
+	code.Push(MakeJmp(9, 1));
+	code.Push(MakeOp(OP_RET, RET_FINAL, REGT_INT, 2));			// 10: return d2
+
+	TArray<int> konstd;
+	konstd.Push(0);
+	konstd.Push(4);
+	TArray<void *> konsta;
+	konsta.Push(nullptr);
+	konsta.Push(native);
+	return MakeKernel("VMBench.NativeCalls", code, konstd, konsta, 3, 1, 3);
+}
+
+//==========================================================================
+//
+// Returns the best time of several runs in nanoseconds per iteration.
+//
+//==========================================================================
+
+static double RunKernel(VMScriptFunction *func, int iterations, int &result)
+{
+	FBenchActor actor = { 2, 100, &actor };
+	double best = 0;
+
+	for (int run = 0; run < 5; run++)
+	{
+		VMValue params[] = { &actor, iterations };
+		VMReturn ret;
+		ret.IntAt(&result);
+
+		cycle_t clock;
+		clock.Reset();
+		clock.Clock();
+		VMCall(func, params, 2, &ret, 1);
+		clock.Unclock();
+
+		double ns = clock.TimeMS() * 1e6 / iterations;
+		if (run == 0 || ns < best) best = ns;
+	}
+	return best;
+}
+
+CCMD(vmbench)
+{
+	// Not kept around because a restart deletes all VM functions.
+	VMScriptFunction *kernels[] = { MakeFieldTestKernel(), MakeNativeCallKernel() };
+
+	int iterations = argv.argc() > 1 ? max(1, (int)strtol(argv[1], nullptr, 0)) : 1000000;
+	int superops = VMSetSuperOps(false);
+
+	Printf("Dispatch: %s, %d iterations, ns per iteration\n", VMDispatchMode, iterations);
+	for (auto func : kernels)
+	{
+		int plainresult, fusedresult;
+		VMSetSuperOps(false);
+		double plain = RunKernel(func, iterations, plainresult);
+		if (superops < 0)
+		{
+			// Only the direct threaded interpreter has superinstructions.
+			Printf("%-20s %8.2f\n", func->PrintableName.GetChars(), plain);
+			continue;
+		}
+		VMSetSuperOps(true);
+		double fused = RunKernel(func, iterations, fusedresult);
+
+		Printf("%-20s %8.2f plain %8.2f superinstructions (%.2fx)%s\n", func->PrintableName.GetChars(), plain, fused, fused > 0 ? plain / fused : 0.,
+			plainresult != fusedresult ? TEXTCOLOR_RED " RESULTS DIFFER" : "");
+	}
+	if (superops >= 0) VMSetSuperOps(superops != 0);
+}
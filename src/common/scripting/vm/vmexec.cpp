@@ -43,6 +43,7 @@
 #include "basics.h"
 #include "texturemanager.h"
 #include "palutil.h"
+#include "c_cvars.h"
 
 extern cycle_t VMCycles[10];
 extern int VMCalls[10];
@@ -61,9 +62,19 @@ void ThrowVMException(VMException *x);
 #define COMPGOTO 1
 #endif
 
+// With direct threading every script function gets a table with the handler
+// address for each of its instructions, so dispatching no longer needs to look
+// up the opcode first. The table also allows replacing common instruction
+// pairs with superinstructions without changing the bytecode itself.
+// Only the unchecked engine uses this. Define VM_DIRECT_THREADING as 0 to
+// build the plain computed goto interpreter instead.
+#if !defined(VM_DIRECT_THREADING) && COMPGOTO
+#define VM_DIRECT_THREADING 1
+#endif
+
 #if COMPGOTO
 #define OP(x)	x
-#define NEXTOP	do { pc++; unsigned op = pc->op; a = pc->a; goto *ops[op]; } while(0)
+#define NEXTOP	do { pc++; a = pc->a; goto *DISPATCH; } while(0)
 #else
 #define OP(x)	case OP_##x
 #define NEXTOP	pc++; break
@@ -108,6 +119,114 @@ void ThrowVMException(VMException *x);
 	if (a == NULL) { ThrowAbortException(x, nullptr); return 0; } \
 	ptr = (VM_SBYTE *)a + o
 
+//===========================================================================
+//
+// Superinstructions for the direct threaded interpreter. Each one replaces
+// the first instruction of a pair and executes both. Jumps into the second
+// instruction still work because its own table entry remains unchanged.
+// The PARAM variants are specialized for a single register type.
+//
+//===========================================================================
+
+// for vmbench
+const char *VMDispatchMode =
+#if VM_DIRECT_THREADING
+	"direct threaded";
+#elif COMPGOTO
+	"computed goto";
+#else
+	"switch";
+#endif
+
+#if VM_DIRECT_THREADING
+enum ESuperOp
+{
+	SOP_LBIT_EQ_K,		// if (bFlag)
+	SOP_LW_EQ_K,		// if (intfield)
+	SOP_LW_LT_RK,		// if (intfield < const) and variants
+	SOP_LW_LE_RK,
+	SOP_LO_EQA_K,		// if (objfield)
+	SOP_LP_EQA_K,		// if (ptrfield)
+	SOP_PARAM_D,
+	SOP_PARAM_F,
+	SOP_PARAM_A,
+	SOP_PARAM_KD,
+	SOP_PARAM_KA,
+
+	NUM_SUPEROPS
+};
+
+CUSTOM_CVAR(Bool, vm_superops, true, 0)
+{
+	// Existing tables stay valid for functions that are currently running. They just get replaced on the next call.
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (!(func->VarFlags & VARF_Native)) static_cast<VMScriptFunction *>(func)->ThreadedCode = nullptr;
+	}
+}
+
+static int SuperOp(const VMOP *code, int i, int count)
+{
+	bool haspair = i + 1 < count;
+	switch (code[i].op)
+	{
+	case OP_LBIT:
+		if (haspair && code[i + 1].op == OP_EQ_K) return SOP_LBIT_EQ_K;
+		break;
+
+	case OP_LW:
+		if (haspair && code[i + 1].op == OP_EQ_K) return SOP_LW_EQ_K;
+		if (haspair && code[i + 1].op == OP_LT_RK) return SOP_LW_LT_RK;
+		if (haspair && code[i + 1].op == OP_LE_RK) return SOP_LW_LE_RK;
+		break;
+
+	case OP_LO:
+		if (haspair && code[i + 1].op == OP_EQA_K) return SOP_LO_EQA_K;
+		break;
+
+	case OP_LP:
+		if (haspair && code[i + 1].op == OP_EQA_K) return SOP_LP_EQA_K;
+		break;
+
+	case OP_PARAM:
+		switch (code[i].a)
+		{
+		case REGT_INT:					return SOP_PARAM_D;
+		case REGT_FLOAT:				return SOP_PARAM_F;
+		case REGT_POINTER:				return SOP_PARAM_A;
+		case REGT_INT | REGT_KONST:		return SOP_PARAM_KD;
+		case REGT_POINTER | REGT_KONST:	return SOP_PARAM_KA;
+		}
+		break;
+	}
+	return -1;
+}
+
+static void * const *VMBuildThreadedCode(VMScriptFunction *sfunc, void * const *ops, void * const *superops)
+{
+	auto table = (void **)ClassDataAllocator.Alloc(sfunc->CodeSize * sizeof(void *));
+	for (int i = 0; i < sfunc->CodeSize; i++)
+	{
+		int sop = vm_superops ? SuperOp(sfunc->Code, i, sfunc->CodeSize) : -1;
+		table[i] = sop >= 0 ? superops[sop] : ops[sfunc->Code[i].op];
+	}
+	sfunc->ThreadedCode = table;
+	return table;
+}
+#endif
+
+// for vmbench. Returns the previous setting, or -1 if there are no superinstructions.
+int VMSetSuperOps(bool enable)
+{
+#if VM_DIRECT_THREADING
+	bool old = vm_superops;
+	vm_superops = enable;
+	return old;
+#else
+	return -1;
+#endif
+}
+
 #ifdef NDEBUG
 #define WAS_NDEBUG 1
 #else
@@ -119,10 +238,14 @@ void ThrowVMException(VMException *x);
 #endif
 #undef assert
 #include <assert.h>
+#define VM_THREADED 0
+#define DISPATCH ops[pc->op]
 struct VMExec_Checked
 {
 #include "vmexec.h"
 };
+#undef VM_THREADED
+#undef DISPATCH
 #if WAS_NDEBUG
 #define NDEBUG
 #endif
@@ -132,10 +255,19 @@ struct VMExec_Checked
 #endif
 #undef assert
 #include <assert.h>
+#if VM_DIRECT_THREADING
+#define VM_THREADED 1
+#define DISPATCH threaded[pc - code]
+#else
+#define VM_THREADED 0
+#define DISPATCH ops[pc->op]
+#endif
 struct VMExec_Unchecked
 {
 #include "vmexec.h"
 };
+#undef VM_THREADED
+#undef DISPATCH
 #if !WAS_NDEBUG
 #undef NDEBUG
 #endif
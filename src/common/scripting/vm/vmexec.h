@@ -45,6 +45,14 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 #define xx(op,sym,mode,alt,kreg,ktype) &&op,
 #include "vmops.h"
 	};
+#endif
+#if VM_THREADED
+	// Must be in the same order as ESuperOp.
+	static void * const superops[NUM_SUPEROPS] =
+	{
+		&&LBIT_EQ_K, &&LW_EQ_K, &&LW_LT_RK, &&LW_LE_RK, &&LO_EQA_K, &&LP_EQA_K,
+		&&PARAM_D, &&PARAM_F, &&PARAM_A, &&PARAM_KD, &&PARAM_KA,
+	};
 #endif
 	//const VMOP *exception_frames[MAX_TRY_DEPTH];
 	//int try_depth = 0;
@@ -55,6 +63,10 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 	const FString *konsts = sfunc->KonstS;
 	const FVoidObj *konsta = sfunc->KonstA;
 	const VMOP *pc = sfunc->Code;
+#if VM_THREADED
+	const VMOP *code = pc;
+	void * const *threaded = sfunc->ThreadedCode != nullptr ? sfunc->ThreadedCode : VMBuildThreadedCode(sfunc, ops, superops);
+#endif
 
 	assert(!(f->Func->VarFlags & VARF_Native) && "Only script functions should ever reach VMExec");
 
@@ -900,6 +912,10 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 					throw;
 				}
 			}
+			else if (call->ConstReturnKind != VMCONSTRET_None)
+			{
+				numret1 = VMCallConstReturn(call, returns, C);
+			}
 			else
 			{
 				auto sfunc1 = static_cast<VMScriptFunction *>(call);
@@ -1937,6 +1953,83 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		CMPJMP(reg.a[B] == konsta[C].v);
 		NEXTOP;
 
+#if VM_THREADED
+	// Superinstructions, see ESuperOp. These are never part of the bytecode.
+	LBIT_EQ_K:
+		ASSERTD(a); ASSERTA(B);
+		GETADDR(PB,0,X_READ_NIL);
+		reg.d[a] = !!(*(VM_UBYTE *)ptr & C);
+		pc++; a = pc->a;
+		ASSERTD(B); ASSERTKD(C);
+		CMPJMP(reg.d[B] == konstd[C]);
+		NEXTOP;
+	LW_EQ_K:
+		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.d[a] = *(VM_SWORD *)ptr;
+		pc++; a = pc->a;
+		ASSERTD(B); ASSERTKD(C);
+		CMPJMP(reg.d[B] == konstd[C]);
+		NEXTOP;
+	LW_LT_RK:
+		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.d[a] = *(VM_SWORD *)ptr;
+		pc++; a = pc->a;
+		ASSERTD(B); ASSERTKD(C);
+		CMPJMP(reg.d[B] < konstd[C]);
+		NEXTOP;
+	LW_LE_RK:
+		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.d[a] = *(VM_SWORD *)ptr;
+		pc++; a = pc->a;
+		ASSERTD(B); ASSERTKD(C);
+		CMPJMP(reg.d[B] <= konstd[C]);
+		NEXTOP;
+	LO_EQA_K:
+		ASSERTA(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.a[a] = GC::ReadBarrier(*(DObject **)ptr);
+		pc++; a = pc->a;
+		ASSERTA(B); ASSERTKA(C);
+		CMPJMP(reg.a[B] == konsta[C].v);
+		NEXTOP;
+	LP_EQA_K:
+		ASSERTA(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.a[a] = *(void **)ptr;
+		pc++; a = pc->a;
+		ASSERTA(B); ASSERTKA(C);
+		CMPJMP(reg.a[B] == konsta[C].v);
+		NEXTOP;
+	PARAM_D:
+		assert(f->NumParam < sfunc->MaxParam);
+		ASSERTD(BC);
+		::new(&reg.param[f->NumParam++]) VMValue(reg.d[BC]);
+		NEXTOP;
+	PARAM_F:
+		assert(f->NumParam < sfunc->MaxParam);
+		ASSERTF(BC);
+		::new(&reg.param[f->NumParam++]) VMValue(reg.f[BC]);
+		NEXTOP;
+	PARAM_A:
+		assert(f->NumParam < sfunc->MaxParam);
+		ASSERTA(BC);
+		::new(&reg.param[f->NumParam++]) VMValue(reg.a[BC]);
+		NEXTOP;
+	PARAM_KD:
+		assert(f->NumParam < sfunc->MaxParam);
+		ASSERTKD(BC);
+		::new(&reg.param[f->NumParam++]) VMValue(konstd[BC]);
+		NEXTOP;
+	PARAM_KA:
+		assert(f->NumParam < sfunc->MaxParam);
+		ASSERTKA(BC);
+		::new(&reg.param[f->NumParam++]) VMValue(konsta[BC].v);
+		NEXTOP;
+#endif
+
 	OP(NOP):
 		NEXTOP;
 	}
@@ -58,6 +58,9 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int maxFrames) { return FString(); }
 void JitRelease() {}
+void JitPrecompile(const TArray<VMScriptFunction *> &functions) {}
+void JitFinishPrecompile(TArray<double> *times) {}
+void JitStopPrecompile() {}
 #endif
 
 cycle_t VMCycles[10];
@@ -117,6 +120,7 @@ VMScriptFunction::VMScriptFunction(FName name)
 	Name = name;
 	LineInfo = nullptr;
 	Code = NULL;
+	ThreadedCode = nullptr;
 	KonstD = NULL;
 	KonstF = NULL;
 	KonstS = NULL;
@@ -268,16 +272,52 @@ int VMScriptFunction::PCToLine(const VMOP *pc)
 	return -1;
 }
 
+//===========================================================================
+//
+// VMScriptFunction :: ClassifyConstReturn
+//
+// Checks if the function does nothing but return a constant. This is very
+// common for the base versions of virtual hooks like CanCollideWith, whose
+// call sites can then skip the call entirely if that is the version that
+// gets picked at run time.
+//
+//===========================================================================
+
+void VMScriptFunction::ClassifyConstReturn()
+{
+	ConstReturnKind = VMCONSTRET_None;
+	if (Code == nullptr || CodeSize == 0 || ExtraSpace > 0) return;
+
+	const VMOP &op = Code[0];
+	if (op.word == (0x00808000|OP_RET))
+	{
+		ConstReturnKind = VMCONSTRET_Empty;
+	}
+	else if (op.op == OP_RETI && op.a == RET_FINAL)
+	{
+		ConstReturnKind = VMCONSTRET_Int;
+		ConstReturnInt = op.i16;
+	}
+	else if (op.op == OP_RET && op.a == RET_FINAL && op.b == (REGT_INT | REGT_KONST))
+	{
+		ConstReturnKind = VMCONSTRET_Int;
+		ConstReturnInt = KonstD[op.c];
+	}
+	else if (op.op == OP_RET && op.a == RET_FINAL && op.b == (REGT_FLOAT | REGT_KONST))
+	{
+		ConstReturnKind = VMCONSTRET_Float;
+		ConstReturnFloat = KonstF[op.c];
+	}
+}
+
 static bool CanJit(VMScriptFunction *func)
 {
-	// Asmjit has a 256 register limit. Stay safely away from it as the jit compiler uses a few for temporaries as well.
-	// Any function exceeding the limit will use the VM - a fair punishment to someone for writing a function so bloated ;)
+	// Any function exceeding the register limit will use the VM - a fair punishment to someone for writing a function so bloated ;)
 
-	int maxregs = 200;
-	if (func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS < maxregs)
+	if (JitRegisterCount(func) < JIT_MAX_REGS)
 		return true;
 
-	Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), func->NumRegA + func->NumRegD + func->NumRegF + func->NumRegS, maxregs);
+	Printf(TEXTCOLOR_ORANGE "%s is using too many registers (%d of max %d)! Function will not use native code.\n", func->PrintableName.GetChars(), JitRegisterCount(func), (int)JIT_MAX_REGS);
 
 	return false;
 }
@@ -294,7 +334,11 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 #ifdef HAVE_VM_JIT
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
+		JitFuncPtr code = nullptr;
+		// If the background compiler failed this compiles it again so that the errors get printed.
+		if (!JitTakePrecompiled(static_cast<VMScriptFunction*>(func), code) || !code)
+			code = JitCompile(static_cast<VMScriptFunction*>(func));
+		func->ScriptCall = code;
 		if (!func->ScriptCall)
 			func->ScriptCall = VMExec;
 	}
@@ -560,17 +604,15 @@ int VMCall(VMFunction *func, VMValue *params, int numparams, VMReturn *results,
 		else
 		{
 			auto code = static_cast<VMScriptFunction *>(func)->Code;
-			// handle empty functions consisting of a single return explicitly so that empty virtual callbacks do not need to set up an entire VM frame.
+			// handle functions consisting of a single return explicitly so that trivial virtual callbacks do not need to set up an entire VM frame.
 			// code cann be null here in case of some non-fatal DECORATE errors.
-			if (code == nullptr || code->word == (0x00808000|OP_RET))
+			if (code == nullptr)
 			{
 				return 0;
 			}
-			else if (code->word == (0x00048000|OP_RET))
+			else if (func->ConstReturnKind != VMCONSTRET_None)
 			{
-				if (numresults == 0) return 0;
-				results[0].SetInt(static_cast<VMScriptFunction *>(func)->KonstD[0]);
-				return 1;
+				return VMCallConstReturn(func, results, numresults);
 			}
 			else
 			{
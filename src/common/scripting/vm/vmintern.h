@@ -2,6 +2,7 @@
 
 #include "vm.h"
 #include <csetjmp>
+#include <atomic>
 
 class VMScriptFunction;
 
@@ -444,6 +445,13 @@ typedef std::pair<const class PType *, unsigned> FTypeAndOffset;
 
 typedef int(*JitFuncPtr)(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 
+enum EJitState
+{
+	JIT_Pending,
+	JIT_Compiling,
+	JIT_Done,
+};
+
 class VMScriptFunction : public VMFunction
 {
 public:
@@ -452,6 +460,7 @@ public:
 	void Alloc(int numops, int numkonstd, int numkonstf, int numkonsts, int numkonsta, int numlinenumbers);
 
 	VMOP *Code;
+	void * const *ThreadedCode;	// handler addresses for the direct threaded interpreter, created on first execution.
 	FStatementInfo *LineInfo;
 	FString SourceFileName;
 	int *KonstD;
@@ -472,13 +481,25 @@ public:
 	VM_UHALF NumKonstA;
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
+	std::atomic<uint8_t> JitState { JIT_Pending };	// Synchronizes the background JIT compiler with FirstScriptCall.
+	JitFuncPtr JitCode = nullptr;	// Code created by the background JIT compiler. Only valid once JitState is JIT_Done.
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
 
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
 	int AllocExtraStack(PType *type);
 	int PCToLine(const VMOP *pc);
+	void ClassifyConstReturn();
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 };
+
+// Performs a call to a function with an ConstReturnKind other than VMCONSTRET_None.
+inline int VMCallConstReturn(const VMFunction *func, VMReturn *ret, int numret)
+{
+	if (numret == 0 || func->ConstReturnKind == VMCONSTRET_Empty) return 0;
+	if (func->ConstReturnKind == VMCONSTRET_Int) ret->SetInt(func->ConstReturnInt);
+	else ret->SetFloat(func->ConstReturnFloat);
+	return 1;
+}
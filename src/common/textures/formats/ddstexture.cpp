@@ -183,6 +183,9 @@ protected:
 	void DecompressDXT5 (FileReader &lump, bool premultiplied, uint8_t *buffer, int pixelmode);
 
 	int CopyPixels(FBitmap *bmp, int conversion) override;
+	bool SupportsDecodePixels() override { return true; }
+	bool DecodePixels(FileReader &lump, FBitmap *bmp, int *trans) override;
+	int ReadPixels(FileReader &lump, FBitmap *bmp);
 
 	friend class FTexture;
 };
@@ -783,7 +786,17 @@ void FDDSTexture::DecompressDXT5 (FileReader &lump, bool premultiplied, uint8_t
 int FDDSTexture::CopyPixels(FBitmap *bmp, int conversion)
 {
 	auto lump = fileSystem.OpenFileReader (SourceLump);
+	return ReadPixels(lump, bmp);
+}
 
+bool FDDSTexture::DecodePixels(FileReader &lump, FBitmap *bmp, int *trans)
+{
+	*trans = ReadPixels(lump, bmp);
+	return true;
+}
+
+int FDDSTexture::ReadPixels(FileReader &lump, FBitmap *bmp)
+{
 	uint8_t *TexBuffer = bmp->GetPixels();
 
 	lump.Seek (sizeof(DDSURFACEDESC2) + 4, FileReader::SeekSet);
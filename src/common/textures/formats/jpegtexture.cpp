@@ -173,6 +173,13 @@ void JPEG_OutputMessage (j_common_ptr cinfo)
 	Printf (TEXTCOLOR_ORANGE "JPEG failure: %s\n", buffer);
 }
 
+// For decoding off the main thread, where nothing may be printed.
+// The image is then decoded again by the main thread to report the problem.
+static void JPEG_QuietMessage (j_common_ptr cinfo)
+{
+	*(bool *)cinfo->client_data = true;
+}
+
 //==========================================================================
 //
 // A JPEG texture
@@ -185,7 +192,12 @@ public:
 	FJPEGTexture (int lumpnum, int width, int height);
 
 	int CopyPixels(FBitmap *bmp, int conversion) override;
+	bool SupportsDecodePixels() override { return true; }
+	bool DecodePixels(FileReader &lump, FBitmap *bmp, int *trans) override;
 	PalettedPixels CreatePalettedPixels(int conversion) override;
+
+protected:
+	bool ReadPixels(FileReader &lump, FBitmap *bmp, bool quiet);
 };
 
 //==========================================================================
@@ -402,17 +414,30 @@ PalettedPixels FJPEGTexture::CreatePalettedPixels(int conversion)
 
 int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 {
-	PalEntry pe[256];
-
 	auto lump = fileSystem.OpenFileReader (SourceLump);
+	ReadPixels(lump, bmp, false);
+	return 0;
+}
+
+bool FJPEGTexture::DecodePixels(FileReader &lump, FBitmap *bmp, int *trans)
+{
+	*trans = 0;
+	return ReadPixels(lump, bmp, true);
+}
+
+bool FJPEGTexture::ReadPixels(FileReader &lump, FBitmap *bmp, bool quiet)
+{
+	PalEntry pe[256];
+	bool failed = false;
 
 	jpeg_decompress_struct cinfo;
 	jpeg_error_mgr jerr;
 
 	cinfo.err = jpeg_std_error(&jerr);
-	cinfo.err->output_message = JPEG_OutputMessage;
+	cinfo.err->output_message = quiet ? JPEG_QuietMessage : JPEG_OutputMessage;
 	cinfo.err->error_exit = JPEG_ErrorExit;
 	jpeg_create_decompress(&cinfo);
+	cinfo.client_data = &failed;
 
 	FLumpSourceMgr sourcemgr(&lump, &cinfo);
 	try
@@ -425,7 +450,8 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 			(cinfo.out_color_space == JCS_YCbCr && cinfo.num_components == 3) ||
 			(cinfo.out_color_space == JCS_GRAYSCALE && cinfo.num_components == 1)))
 		{
-			Printf(TEXTCOLOR_ORANGE "Unsupported color format in %s\n", fileSystem.GetFileFullPath(SourceLump).GetChars());
+			if (!quiet) Printf(TEXTCOLOR_ORANGE "Unsupported color format in %s\n", fileSystem.GetFileFullPath(SourceLump).GetChars());
+			failed = true;
 		}
 		else
 		{
@@ -478,9 +504,10 @@ int FJPEGTexture::CopyPixels(FBitmap *bmp, int conversion)
 	}
 	catch (int)
 	{
-		Printf(TEXTCOLOR_ORANGE "JPEG error in %s\n", fileSystem.GetFileFullPath(SourceLump).GetChars());
+		if (!quiet) Printf(TEXTCOLOR_ORANGE "JPEG error in %s\n", fileSystem.GetFileFullPath(SourceLump).GetChars());
+		failed = true;
 	}
 	jpeg_destroy_decompress(&cinfo);
-	return 0;
+	return !failed;
 }
 
@@ -43,6 +43,7 @@
 #include "printf.h"
 #include "texturemanager.h"
 #include "filesystem.h"
+#include "lumpcache.h"
 
 //==========================================================================
 //
@@ -56,11 +57,15 @@ public:
 	FPNGTexture (FileReader &lump, int lumpnum, int width, int height, uint8_t bitdepth, uint8_t colortype, uint8_t interlace);
 
 	int CopyPixels(FBitmap *bmp, int conversion) override;
+	bool SupportsDecodePixels() override { return true; }
+	bool DecodePixels(FileReader &lump, FBitmap *bmp, int *trans) override;
 	PalettedPixels CreatePalettedPixels(int conversion) override;
 
 protected:
+	int ReadPixels(FileReader *lump, FBitmap *bmp, bool uselumpcache = true);
 	void ReadAlphaRemap(FileReader *lump, uint8_t *alpharemap);
 	void SetupPalette(FileReader &lump);
+	void ReadIDAT(FileReader &lump, uint8_t *buffer, int pitch, bool uselumpcache = true);
 
 	uint8_t BitDepth;
 	uint8_t ColorType;
@@ -405,6 +410,41 @@ void FPNGTexture::ReadAlphaRemap(FileReader *lump, uint8_t *alpharemap)
 	lump->Seek(p, FileReader::SeekSet);
 }
 
+//==========================================================================
+//
+// Decodes the image data or fetches the result of an earlier decode
+// from the lump cache. The output only depends on the lump's content
+// and the pitch, so the cache key only needs to add the latter.
+// The precache decoding threads must not use the lump cache, because
+// getting the key goes through the file system and creates FStrings.
+//
+//==========================================================================
+
+void FPNGTexture::ReadIDAT(FileReader &lump, uint8_t *buffer, int pitch, bool uselumpcache)
+{
+	uint32_t len, id;
+	lump.Seek(StartOfIDAT, FileReader::SeekSet);
+	lump.Read(&len, 4);
+	lump.Read(&id, 4);
+
+	size_t size = size_t(pitch) * Height;
+	if (uselumpcache && UseLumpCache(size))
+	{
+		FString cachekey = fileSystem.GetFileAt(SourceLump)->GetCacheKey();
+		if (cachekey.IsNotEmpty())
+		{
+			cachekey.AppendFormat("-idat-%d", pitch);
+			if (ReadCachedLump(cachekey, buffer, size)) return;
+			if (M_ReadIDAT(lump, buffer, Width, Height, pitch, BitDepth, ColorType, Interlace, BigLong((unsigned int)len)))
+			{
+				WriteCachedLump(cachekey, buffer, size);
+			}
+			return;
+		}
+	}
+	M_ReadIDAT(lump, buffer, Width, Height, pitch, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+}
+
 //==========================================================================
 //
 //
@@ -426,15 +466,10 @@ PalettedPixels FPNGTexture::CreatePalettedPixels(int conversion)
 	}
 	else
 	{
-		uint32_t len, id;
-		lump->Seek (StartOfIDAT, FileReader::SeekSet);
-		lump->Read(&len, 4);
-		lump->Read(&id, 4);
-
 		bool alphatex = conversion == luminance;
 		if (ColorType == 0 || ColorType == 3)	/* Grayscale and paletted */
 		{
-			M_ReadIDAT (*lump, Pixels.Data(), Width, Height, Width, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			ReadIDAT(*lump, Pixels.Data(), Width);
 
 			if (Width == Height)
 			{
@@ -482,7 +517,7 @@ PalettedPixels FPNGTexture::CreatePalettedPixels(int conversion)
 			uint8_t *in, *out;
 			int x, y, pitch, backstep;
 
-			M_ReadIDAT (*lump, tempix, Width, Height, Width*bytesPerPixel, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+			ReadIDAT(*lump, tempix, Width*bytesPerPixel);
 			in = tempix;
 			out = Pixels.Data();
 
@@ -553,6 +588,18 @@ PalettedPixels FPNGTexture::CreatePalettedPixels(int conversion)
 //===========================================================================
 
 int FPNGTexture::CopyPixels(FBitmap *bmp, int conversion)
+{
+	auto lump = fileSystem.OpenFileReader(SourceLump);
+	return ReadPixels(&lump, bmp);
+}
+
+bool FPNGTexture::DecodePixels(FileReader &lump, FBitmap *bmp, int *trans)
+{
+	*trans = ReadPixels(&lump, bmp, false);
+	return true;
+}
+
+int FPNGTexture::ReadPixels(FileReader *lump, FBitmap *bmp, bool uselumpcache)
 {
 	// Parse pre-IDAT chunks. I skip the CRCs. Is that bad?
 	PalEntry pe[256];
@@ -561,12 +608,6 @@ int FPNGTexture::CopyPixels(FBitmap *bmp, int conversion)
 	int pixwidth = Width * bpp[ColorType];
 	int transpal = false;
 
-	FileReader *lump;
-	FileReader lfr;
-
-	lfr = fileSystem.OpenFileReader(SourceLump);
-	lump = &lfr;
-
 	lump->Seek(33, FileReader::SeekSet);
 	for(int i = 0; i < 256; i++)	// default to a gray map
 		pe[i] = PalEntry(255,i,i,i);
@@ -621,10 +662,7 @@ int FPNGTexture::CopyPixels(FBitmap *bmp, int conversion)
 
 	uint8_t * Pixels = new uint8_t[pixwidth * Height];
 
-	lump->Seek (StartOfIDAT, FileReader::SeekSet);
-	lump->Read(&len, 4);
-	lump->Read(&id, 4);
-	M_ReadIDAT (*lump, Pixels, Width, Height, pixwidth, BitDepth, ColorType, Interlace, BigLong((unsigned int)len));
+	ReadIDAT(*lump, Pixels, pixwidth, uselumpcache);
 
 	switch (ColorType)
 	{
@@ -49,6 +49,7 @@
 #include "texturemanager.h"
 #include "c_cvars.h"
 #include "hw_material.h"
+#include <mutex>
 
 FTexture *CreateBrightmapTexture(FImageSource*);
 
@@ -261,11 +262,16 @@ void FGameTexture::GetGlowColor(float* data)
 {
 	if (isGlowing() && GlowColor == 0)
 	{
-		auto buffer = Base->GetBgraBitmap(nullptr);
-		GlowColor = averageColor((uint32_t*)buffer.GetPixels(), buffer.GetWidth() * buffer.GetHeight(), 153);
+		// Both the walls and the sprites of the hardware renderer's BSP workers can get here.
+		std::lock_guard<std::recursive_mutex> lock(FTexture::LazyDataMutex);
+		if (isGlowing() && GlowColor == 0)
+		{
+			auto buffer = Base->GetBgraBitmap(nullptr);
+			GlowColor = averageColor((uint32_t*)buffer.GetPixels(), buffer.GetWidth() * buffer.GetHeight(), 153);
 
-		// Black glow equals nothing so switch glowing off
-		if (GlowColor == 0) flags &= ~GTexf_Glowing;
+			// Black glow equals nothing so switch glowing off
+			if (GlowColor == 0) flags &= ~GTexf_Glowing;
+		}
 	}
 	data[0] = GlowColor.r * (1 / 255.0f);
 	data[1] = GlowColor.g * (1 / 255.0f);
@@ -328,14 +334,21 @@ bool FGameTexture::ShouldExpandSprite()
 //
 //===========================================================================
 
-void FGameTexture::SetupSpriteData()
+SpritePositioningInfo* FGameTexture::SetupSpriteData()
 {
+	// The sprite workers of the hardware renderer can get here for the same texture at once,
+	// and neither the image arena nor reading the image for trimming are thread safe.
+	std::lock_guard<std::recursive_mutex> lock(FTexture::LazyDataMutex);
+
+	auto info = spi.load(std::memory_order_relaxed);
+	if (info != nullptr) return info;
+
 	// Since this is only needed for real sprites it gets allocated on demand.
 	// It also allocates from the image memory arena because it has the same lifetime and to reduce maintenance.
-	if (spi == nullptr) spi = (SpritePositioningInfo*)ImageArena.Alloc(2 * sizeof(SpritePositioningInfo));
+	info = (SpritePositioningInfo*)ImageArena.Alloc(2 * sizeof(SpritePositioningInfo));
 	for (int i = 0; i < 2; i++)
 	{
-		auto& spi = this->spi[i];
+		auto& spi = info[i];
 		spi.mSpriteU[0] = spi.mSpriteV[0] = 0.f;
 		spi.mSpriteU[1] = spi.mSpriteV[1] = 1.f;
 		spi.spriteWidth = GetTexelWidth();
@@ -348,7 +361,10 @@ void FGameTexture::SetupSpriteData()
 			spi.spriteHeight += 2;
 		}
 	}
-	SetSpriteRect();
+	SetSpriteRect(info);
+	// Only publish it once it is complete.
+	spi.store(info, std::memory_order_release);
+	return info;
 }
 
 //===========================================================================
@@ -359,8 +375,12 @@ void FGameTexture::SetupSpriteData()
 
 void FGameTexture::SetSpriteRect()
 {
+	auto info = spi.load(std::memory_order_acquire);
+	if (info != nullptr) SetSpriteRect(info);
+}
 
-	if (!spi) return;
+void FGameTexture::SetSpriteRect(SpritePositioningInfo* info)
+{
 	auto leftOffset = GetTexelLeftOffset(r_spriteadjustHW);
 	auto topOffset = GetTexelTopOffset(r_spriteadjustHW);
 
@@ -369,7 +389,7 @@ void FGameTexture::SetSpriteRect()
 
 	for (int i = 0; i < 2; i++)
 	{
-		auto& spi = this->spi[i];
+		auto& spi = info[i];
 
 		// mSpriteRect is for positioning the sprite in the scene.
 		spi.mSpriteRect.left = -leftOffset / fxScale;
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <memory>
+#include <atomic>
 #include "vectors.h"
 #include "floatrect.h"
 #include "refcounted.h"
@@ -97,7 +98,7 @@ class FGameTexture
 
 	int8_t shouldUpscaleFlag = 1;
 	ETextureType UseType = ETextureType::Wall;	// This texture's primary purpose
-	SpritePositioningInfo* spi = nullptr;
+	std::atomic<SpritePositioningInfo*> spi{ nullptr };
 
 	ISoftwareTexture* SoftwareTexture = nullptr;
 	FMaterial* Material[5] = {  };
@@ -140,8 +141,9 @@ public:
 	void CreateDefaultBrightmap();
 	void AddAutoMaterials();
 	bool ShouldExpandSprite();
-	void SetupSpriteData();
+	SpritePositioningInfo* SetupSpriteData();
 	void SetSpriteRect();
+	void SetSpriteRect(SpritePositioningInfo* info);
 
 	ETextureType GetUseType() const { return UseType; }
 	void SetUpscaleFlag(int what, bool manual = false) 
@@ -310,7 +312,13 @@ public:
 		DisplayHeight = TexelHeight / y;
 	}
 
-	const SpritePositioningInfo& GetSpritePositioning(int which) { if (spi == nullptr) SetupSpriteData(); return spi[which]; }
+	// This gets called by several sprite processing threads at once.
+	const SpritePositioningInfo& GetSpritePositioning(int which)
+	{
+		auto info = spi.load(std::memory_order_acquire);
+		if (info == nullptr) info = SetupSpriteData();
+		return info[which];
+	}
 	int GetAreas(FloatRect** pAreas) const;
 
 	bool GetTranslucency()
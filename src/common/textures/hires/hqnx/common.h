@@ -25,6 +25,15 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+// SSE2 is part of the x64 baseline so no runtime dispatch is needed.
+#if !defined(NO_SSE) && (defined(_M_X64) || defined(__amd64__) || defined(__SSE2__))
+#define HQX_SSE2
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#endif
+
 #define MASK_2     0x0000FF00
 #define MASK_13    0x00FF00FF
 #define MASK_RGB   0x00FFFFFF
@@ -58,24 +67,90 @@ static inline int Diff(uint32_t c1, uint32_t c2)
     return yuv_diff(rgb_to_yuv(c1), rgb_to_yuv(c2));
 }
 
+/* Returns a bit for each neighbour of w[5] in the 3x3 block w[1..9] that differs from it */
+static inline int yuv_pattern(const uint32_t *w)
+{
+    uint32_t yuv1 = rgb_to_yuv(w[5]);
+    uint32_t yuv[8];
+    static const int neighbours[8] = { 1, 2, 3, 4, 6, 7, 8, 9 };
+
+    for (int n = 0; n < 8; n++)
+    {
+        int k = neighbours[n];
+        yuv[n] = w[k] != w[5] ? rgb_to_yuv(w[k]) : yuv1;
+    }
+
+#ifdef HQX_SSE2
+    // Compare all components at once: a byte is left over after subtracting
+    // its threshold from the absolute difference only if it is exceeded.
+    // The unused top byte gets a threshold that can never be exceeded.
+    const __m128i center = _mm_set1_epi32((int)yuv1);
+    const __m128i thresholds = _mm_set1_epi32((int)(0xff000000 | trY | trU | trV));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_loadu_si128((const __m128i *)&yuv[0]);
+    __m128i hi = _mm_loadu_si128((const __m128i *)&yuv[4]);
+    lo = _mm_or_si128(_mm_subs_epu8(lo, center), _mm_subs_epu8(center, lo));
+    hi = _mm_or_si128(_mm_subs_epu8(hi, center), _mm_subs_epu8(center, hi));
+    lo = _mm_cmpeq_epi32(_mm_subs_epu8(lo, thresholds), zero);
+    hi = _mm_cmpeq_epi32(_mm_subs_epu8(hi, thresholds), zero);
+    int same = _mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+    return ~same & 0xff;
+#else
+    int pattern = 0;
+    for (int n = 0; n < 8; n++)
+    {
+        if (yuv_diff(yuv1, yuv[n])) pattern |= 1 << n;
+    }
+    return pattern;
+#endif
+}
+
 /* Interpolate functions */
+#ifdef HQX_SSE2
+// The weights of all callers add up to 1 << s so every channel fits into
+// 16 bits and the result is the same as the one of the scalar version.
+static inline __m128i Interpolate_load(uint32_t c)
+{
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)c), _mm_setzero_si128());
+}
+
+static inline uint32_t Interpolate_store(__m128i sum, int s)
+{
+    sum = _mm_srl_epi16(sum, _mm_cvtsi32_si128(s));
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+}
+#endif
+
 static inline uint32_t Interpolate_2(uint32_t c1, int w1, uint32_t c2, int w2, int s)
 {
     if (c1 == c2) {
         return c1;
     }
+#ifdef HQX_SSE2
+    return Interpolate_store(_mm_add_epi16(
+        _mm_mullo_epi16(Interpolate_load(c1), _mm_set1_epi16((short)w1)),
+        _mm_mullo_epi16(Interpolate_load(c2), _mm_set1_epi16((short)w2))), s);
+#else
     return
         (((((c1 & MASK_ALPHA) >> 24) * w1 + ((c2 & MASK_ALPHA) >> 24) * w2) << (24-s)) & MASK_ALPHA) +
         ((((c1 & MASK_2) * w1 + (c2 & MASK_2) * w2) >> s) & MASK_2)	+
         ((((c1 & MASK_13) * w1 + (c2 & MASK_13) * w2) >> s) & MASK_13);
+#endif
 }
 
 static inline uint32_t Interpolate_3(uint32_t c1, int w1, uint32_t c2, int w2, uint32_t c3, int w3, int s)
 {
+#ifdef HQX_SSE2
+    return Interpolate_store(_mm_add_epi16(_mm_add_epi16(
+        _mm_mullo_epi16(Interpolate_load(c1), _mm_set1_epi16((short)w1)),
+        _mm_mullo_epi16(Interpolate_load(c2), _mm_set1_epi16((short)w2))),
+        _mm_mullo_epi16(Interpolate_load(c3), _mm_set1_epi16((short)w3))), s);
+#else
     return
         (((((c1 & MASK_ALPHA) >> 24) * w1 + ((c2 & MASK_ALPHA) >> 24) * w2 + ((c3 & MASK_ALPHA) >> 24) * w3) << (24-s)) & MASK_ALPHA) +
         ((((c1 & MASK_2) * w1 + (c2 & MASK_2) * w2 + (c3 & MASK_2) * w3) >> s) & MASK_2) +
         ((((c1 & MASK_13) * w1 + (c2 & MASK_13) * w2 + (c3 & MASK_13) * w3) >> s) & MASK_13);
+#endif
 }
 
 static inline uint32_t Interp1(uint32_t c1, uint32_t c2)
@@ -34,16 +34,22 @@
 **
 */
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "c_cvars.h"
+#include "c_dispatch.h"
 #include "hqnx/hqx.h"
 #ifdef HAVE_MMX
 #include "hqnx_asm/hqnx_asm.h"
 #endif
 #include "xbr/xbrz.h"
 #include "xbr/xbrz_old.h"
-#include "parallel_for.h"
+#include "ctpl.h"
 #include "textures.h"
 #include "texturemanager.h"
+#include "stats.h"
 #include "printf.h"
 
 int upscalemask;
@@ -136,6 +142,57 @@ XBRZ_CVAR(steepdirectionthreshold, 2.2f)
 
 #undef XBRZ_CVAR
 
+static ctpl::thread_pool UpscalePool;
+
+//===========================================================================
+//
+// Calls scaleRows for slices of gl_texture_hqresize_mt_height source rows.
+// The pool threads and the calling thread take the next unprocessed slice
+// until none are left, so a thread that is done with cheap slices helps
+// out with the rest instead of waiting.
+//
+//===========================================================================
+
+template <typename Func>
+static void UpscaleSlices(const int inWidth, const int inHeight, Func scaleRows)
+{
+	const int sliceHeight = gl_texture_hqresize_mt_height;
+
+	if (!gl_texture_hqresize_multithread || inWidth <= gl_texture_hqresize_mt_width || inHeight <= sliceHeight)
+	{
+		scaleRows(0, inHeight);
+		return;
+	}
+
+	// The calling thread takes part so one less is needed in the pool.
+	int numthreads = max(1, (int)std::thread::hardware_concurrency() - 1);
+	if (UpscalePool.size() != numthreads)
+	{
+		UpscalePool.resize(numthreads);
+	}
+
+	const int numSlices = (inHeight + sliceHeight - 1) / sliceHeight;
+	std::atomic<int> nextSlice(0);
+	auto work = [&](int)
+	{
+		for (int slice; (slice = nextSlice++) < numSlices; )
+		{
+			scaleRows(slice * sliceHeight, min(inHeight, (slice + 1) * sliceHeight));
+		}
+	};
+
+	std::vector<std::future<void>> jobs;
+	for (int i = 0; i < numthreads && i < numSlices - 1; i++)
+	{
+		jobs.push_back(UpscalePool.push(work));
+	}
+	work(0);
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+}
+
 static void scale2x ( uint32_t* inputBuffer, uint32_t* outputBuffer, int inWidth, int inHeight )
 {
 	const int width = 2* inWidth;
@@ -315,7 +372,7 @@ static unsigned char *hqNxAsmHelper( void (*hqNxFunction) ( int*, unsigned char*
 }
 #endif
 
-static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*, unsigned*, int, int ),
+static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( uint32_t*, uint32_t*, int, int, int, int ),
 							  const int N,
 							  unsigned char *inputBuffer,
 							  const int inWidth,
@@ -334,7 +391,10 @@ static unsigned char *hqNxHelper( void (HQX_CALLCONV *hqNxFunction) ( unsigned*,
 	outHeight = N *inHeight;
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
-	hqNxFunction( reinterpret_cast<unsigned*>(inputBuffer), reinterpret_cast<unsigned*>(newBuffer), inWidth, inHeight );
+	UpscaleSlices(inWidth, inHeight, [=](int yFirst, int yLast)
+	{
+		hqNxFunction(reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer), inWidth, inHeight, yFirst, yLast);
+	});
 	delete[] inputBuffer;
 	return newBuffer;
 }
@@ -376,9 +436,6 @@ static unsigned char *xbrzHelper( void (*xbrzFunction) ( size_t, const uint32_t*
 
 	unsigned char * newBuffer = new unsigned char[outWidth*outHeight*4];
 
-	const int thresholdWidth  = gl_texture_hqresize_mt_width;
-	const int thresholdHeight = gl_texture_hqresize_mt_height;
-
 	ConfigType cfg;
 	xbrzSetupConfig(cfg);
 
@@ -386,21 +443,11 @@ static unsigned char *xbrzHelper( void (*xbrzFunction) ( size_t, const uint32_t*
 		? xbrz::ColorFormat::ARGB
 		: xbrz::ColorFormat::ARGB_UNBUFFERED;
 
-	if (gl_texture_hqresize_multithread
-		&& inWidth  > thresholdWidth
-		&& inHeight > thresholdHeight)
-	{
-		parallel_for(inHeight, thresholdHeight, [=, &cfg](int sliceY)
-		{
-			xbrzFunction(N, reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer),
-				inWidth, inHeight, colorFormat, cfg, sliceY, sliceY + thresholdHeight);
-		});
-	}
-	else
+	UpscaleSlices(inWidth, inHeight, [=, &cfg](int yFirst, int yLast)
 	{
 		xbrzFunction(N, reinterpret_cast<uint32_t*>(inputBuffer), reinterpret_cast<uint32_t*>(newBuffer),
-			inWidth, inHeight, colorFormat, cfg, 0, std::numeric_limits<int>::max());
-	}
+			inWidth, inHeight, colorFormat, cfg, yFirst, yLast);
+	});
 
 	delete[] inputBuffer;
 	return newBuffer;
@@ -412,6 +459,57 @@ static void xbrzOldScale(size_t factor, const uint32_t* src, uint32_t* trg, int
 }
 
 
+//===========================================================================
+// 
+// Returns the upsampled buffer and frees inputBuffer, or returns nullptr
+// and leaves everything alone if the scaler does not support the factor.
+//
+//===========================================================================
+
+static unsigned char *UpscaleBuffer(int type, int mult, unsigned char *inputBuffer, int inWidth, int inHeight, int &outWidth, int &outHeight)
+{
+	if (type == 1)
+	{
+		if (mult == 2)
+			return scaleNxHelper(&scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			return scaleNxHelper(&scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			return scaleNxHelper(&scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else return nullptr;
+	}
+	else if (type == 2)
+	{
+		if (mult == 2)
+			return hqNxHelper(&hq2x_32_rows, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			return hqNxHelper(&hq3x_32_rows, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			return hqNxHelper(&hq4x_32_rows, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else return nullptr;
+	}
+#ifdef HAVE_MMX
+	else if (type == 3)
+	{
+		if (mult == 2)
+			return hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 3)
+			return hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else if (mult == 4)
+			return hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		else return nullptr;
+	}
+#endif
+	else if (type == 4)
+		return xbrzHelper(xbrz::scale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+	else if (type == 5)
+		return xbrzHelper(xbrzOldScale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+	else if (type == 6)
+		return normalNx(mult, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+	else
+		return nullptr;
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in texbuffer.mBuffer, frees texbuffer.mBuffer and returns
@@ -442,46 +540,9 @@ void FTexture::CreateUpsampledTextureBuffer(FTextureBuffer &texbuffer, bool hasA
 
 	if (!checkonly)
 	{
-		if (type == 1)
-		{
-			if (mult == 2)
-				texbuffer.mBuffer = scaleNxHelper(&scale2x, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = scaleNxHelper(&scale3x, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = scaleNxHelper(&scale4x, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
-		}
-		else if (type == 2)
-		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxHelper(&hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxHelper(&hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxHelper(&hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
-		}
-#ifdef HAVE_MMX
-		else if (type == 3)
-		{
-			if (mult == 2)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq2x_32, 2, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 3)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq3x_32, 3, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else if (mult == 4)
-				texbuffer.mBuffer = hqNxAsmHelper(&HQnX_asm::hq4x_32, 4, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-			else return;
-		}
-#endif
-		else if (type == 4)
-			texbuffer.mBuffer = xbrzHelper(xbrz::scale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 5)
-			texbuffer.mBuffer = xbrzHelper(xbrzOldScale, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else if (type == 6)
-			texbuffer.mBuffer = normalNx(mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
-		else
-			return;
+		auto buffer = UpscaleBuffer(type, mult, texbuffer.mBuffer, inWidth, inHeight, texbuffer.mWidth, texbuffer.mHeight);
+		if (buffer == nullptr) return;
+		texbuffer.mBuffer = buffer;
 	}
 	else
 	{
@@ -520,4 +581,153 @@ void calcShouldUpscale(FGameTexture *tex)
 		return;
 
 	tex->SetUpscaleFlag(1);
-}
\ No newline at end of file
+}
+//===========================================================================
+//
+// Upscales a fixed set of generated textures with every scaler and prints
+// the throughput in source megapixels per second, once on the calling
+// thread only and once with the upscaler threads.
+//
+//===========================================================================
+
+struct FUpscaleBenchTexture
+{
+	int Width, Height;
+	TArray<uint32_t> Pixels;
+};
+
+static void MakeUpscaleBenchTextures(TArray<FUpscaleBenchTexture> &textures)
+{
+	static const uint32_t palette[] = { 0xff4f3b2b, 0xff5f4733, 0xff6f533b, 0xff7f5f43, 0xff3f2f23, 0xff8f6b4b, 0xff9b7757, 0xff2f2317 };
+	uint32_t seed = 0x1d872b41;
+	auto random = [&]() { seed = seed * 1664525 + 1013904223; return seed >> 16; };
+
+	// A brick wall with few colors, like most wall textures.
+	auto &wall = textures[textures.Reserve(1)];
+	wall.Width = wall.Height = 128;
+	for (int y = 0; y < wall.Height; y++)
+	{
+		for (int x = 0; x < wall.Width; x++)
+		{
+			int bx = (x + (y & 16) * 2) & 31;
+			bool mortar = (y & 15) == 0 || bx == 0;
+			wall.Pixels.Push(mortar ? palette[7] : palette[((x + (y & 16) * 2) / 32 + y / 16) % 4 + ((random() & 7) == 0)]);
+		}
+	}
+
+	// A sprite with a transparent background.
+	auto &sprite = textures[textures.Reserve(1)];
+	sprite.Width = 64;
+	sprite.Height = 96;
+	for (int y = 0; y < sprite.Height; y++)
+	{
+		for (int x = 0; x < sprite.Width; x++)
+		{
+			int dx = x - 32, dy = (y - 48) * 2 / 3;
+			int dist = dx * dx + dy * dy;
+			sprite.Pixels.Push(dist >= 900 ? 0 : palette[dist * 7 / 900]);
+		}
+	}
+
+	// Noise is the worst case because no two neighbours are the same.
+	auto &noise = textures[textures.Reserve(1)];
+	noise.Width = noise.Height = 256;
+	for (int i = 0; i < noise.Width * noise.Height; i++)
+	{
+		noise.Pixels.Push(0xff000000 | (random() << 16) | random());
+	}
+
+	// A smooth gradient, like sky textures.
+	auto &gradient = textures[textures.Reserve(1)];
+	gradient.Width = 256;
+	gradient.Height = 128;
+	for (int y = 0; y < gradient.Height; y++)
+	{
+		for (int x = 0; x < gradient.Width; x++)
+		{
+			gradient.Pixels.Push(0xff000000 | (x << 16) | ((x + y) / 2 << 8) | (y * 2));
+		}
+	}
+}
+
+static double RunUpscaleBench(const TArray<FUpscaleBenchTexture> &textures, int type, int mult, int runs, TArray<TArray<uint32_t>> &results)
+{
+	double best = 0;
+	results.Resize(textures.Size());
+
+	for (int run = 0; run < runs; run++)
+	{
+		TArray<unsigned char *> buffers;
+		for (auto &tex : textures)
+		{
+			auto buffer = new unsigned char[tex.Width * tex.Height * 4];
+			memcpy(buffer, tex.Pixels.Data(), tex.Width * tex.Height * 4);
+			buffers.Push(buffer);
+		}
+
+		cycle_t clock;
+		clock.Reset();
+		clock.Clock();
+		for (unsigned i = 0; i < textures.Size(); i++)
+		{
+			int outWidth, outHeight;
+			buffers[i] = UpscaleBuffer(type, mult, buffers[i], textures[i].Width, textures[i].Height, outWidth, outHeight);
+		}
+		clock.Unclock();
+
+		for (unsigned i = 0; i < textures.Size(); i++)
+		{
+			auto &result = results[i];
+			result.Resize(textures[i].Width * textures[i].Height * mult * mult);
+			memcpy(result.Data(), buffers[i], result.Size() * 4);
+			delete[] buffers[i];
+		}
+
+		double ms = clock.TimeMS();
+		if (run == 0 || ms < best) best = ms;
+	}
+
+	double pixels = 0;
+	for (auto &tex : textures) pixels += tex.Width * tex.Height;
+	return best > 0 ? pixels / (best * 1000) : 0;
+}
+
+CCMD(hqresizebench)
+{
+	static const struct { int type; const char *name; int maxmult; } scalers[] =
+	{
+		{ 1, "scaleNx", 4 },
+		{ 2, "hqNx", 4 },
+#ifdef HAVE_MMX
+		{ 3, "hqNx MMX", 4 },
+#endif
+		{ 4, "xBRZ", 6 },
+		{ 5, "xBRZ old", 6 },
+		{ 6, "normalNx", 6 },
+	};
+
+	TArray<FUpscaleBenchTexture> textures;
+	MakeUpscaleBenchTextures(textures);
+
+	int runs = argv.argc() > 1 ? max(1, (int)strtol(argv[1], nullptr, 0)) : 5;
+	bool multithread = gl_texture_hqresize_multithread;
+
+	Printf("%d threads, best of %d runs, source MPixels/s\n", max(1, (int)std::thread::hardware_concurrency()), runs);
+	for (auto &scaler : scalers)
+	{
+		for (int mult = 2; mult <= scaler.maxmult; mult++)
+		{
+			TArray<TArray<uint32_t>> single, pooled;
+			gl_texture_hqresize_multithread = false;
+			double singlerate = RunUpscaleBench(textures, scaler.type, mult, runs, single);
+			gl_texture_hqresize_multithread = true;
+			double pooledrate = RunUpscaleBench(textures, scaler.type, mult, runs, pooled);
+			bool same = true;
+			for (unsigned i = 0; i < textures.Size(); i++) same &= single[i] == pooled[i];
+
+			Printf("%-10s x%d %8.2f 1 thread %8.2f pooled (%.2fx)%s\n", scaler.name, mult, singlerate, pooledrate, singlerate > 0 ? pooledrate / singlerate : 0.,
+				!same ? TEXTCOLOR_RED " RESULTS DIFFER" : "");
+		}
+	}
+	gl_texture_hqresize_multithread = multithread;
+}
@@ -34,12 +34,18 @@
 **
 */
 
+#include <memory>
+#include <thread>
+#include <vector>
+
 #include "bitmap.h"
 #include "image.h"
 #include "filesystem.h"
 #include "files.h"
 #include "cmdlib.h"
 #include "palettecontainer.h"
+#include "c_cvars.h"
+#include "ctpl.h"
 
 FMemArena ImageArena(32768);
 TArray<FImageSource *>FImageSource::ImageForLump;
@@ -65,6 +71,35 @@ struct PrecacheDataRgba
 TArray<PrecacheDataPaletted> precacheDataPaletted;
 TArray<PrecacheDataRgba> precacheDataRgba;
 
+// Precached true color images whose format supports DecodePixels get decoded on worker
+// threads, in the order they were registered, which is the order the precaching code
+// requests them in. GetCachedBitmap picks up the result as a regular cache entry and
+// only has to wait if the worker isn't done yet. Lumps are read on the main thread
+// since the file system isn't thread safe.
+CVAR(Bool, r_precachethreads, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+enum
+{
+	// How far the decoding may run ahead of the images that were taken from it.
+	MaxDecodesAhead = 64,
+};
+
+struct PrecacheDecode
+{
+	FImageSource *Image;
+	FileData Lump;
+	FBitmap Pixels;
+	int TransInfo = 0;
+	bool Success = false;
+	bool Taken = false;
+	std::future<void> Done;
+};
+
+static ctpl::thread_pool DecodePool;
+static std::vector<std::unique_ptr<PrecacheDecode>> precacheDecodes;
+static TMap<int, unsigned> precacheDecodeIndex;
+static unsigned nextDecode, decodeLimit;
+
 //===========================================================================
 // 
 // the default just returns an empty texture.
@@ -206,6 +241,7 @@ FBitmap FImageSource::GetCachedBitmap(const PalEntry *remap, int conversion, int
 	else
 	{
 		if (conversion == luminance) conversion = normal;	// luminance has no meaning for true color.
+		if (conversion == normal) FinishDecode(this);
 		// Do we have this image in the cache?
 		unsigned index = conversion != normal? UINT_MAX : precacheDataRgba.FindEx([=](PrecacheDataRgba &entry) { return entry.ImageID == imageID; });
 		if (index < precacheDataRgba.Size())
@@ -287,11 +323,13 @@ void FImageSource::CollectForPrecache(PrecacheInfo &info, bool requiretruecolor)
 
 void FImageSource::BeginPrecaching()
 {
+	ClearDecodes();
 	precacheInfo.Clear();
 }
 
 void FImageSource::EndPrecaching()
 {
+	ClearDecodes();
 	precacheDataPaletted.Clear();
 	precacheDataRgba.Clear();
 }
@@ -299,6 +337,111 @@ void FImageSource::EndPrecaching()
 void FImageSource::RegisterForPrecache(FImageSource *img, bool requiretruecolor)
 {
 	img->CollectForPrecache(precacheInfo, requiretruecolor);
+	if (requiretruecolor && r_precachethreads && img->SupportsDecodePixels())
+	{
+		QueueDecode(img);
+	}
+}
+
+//==========================================================================
+//
+// Threaded decoding of precached images
+//
+//==========================================================================
+
+void FImageSource::QueueDecode(FImageSource *img)
+{
+	if (precacheDecodeIndex.CheckKey(img->ImageID)) return;
+
+	if (precacheDecodes.empty())
+	{
+		// Leave one core to the thread that creates the textures.
+		int numthreads = max(1, (int)std::thread::hardware_concurrency() - 1);
+		if (DecodePool.size() != numthreads)
+		{
+			DecodePool.resize(numthreads);
+		}
+		nextDecode = 0;
+		decodeLimit = MaxDecodesAhead;
+	}
+	precacheDecodeIndex.Insert(img->ImageID, (unsigned)precacheDecodes.size());
+	precacheDecodes.emplace_back(new PrecacheDecode);
+	precacheDecodes.back()->Image = img;
+	SubmitDecodes();
+}
+
+void FImageSource::SubmitDecodes()
+{
+	while (nextDecode < precacheDecodes.size() && nextDecode < decodeLimit)
+	{
+		auto decode = precacheDecodes[nextDecode++].get();
+		if (decode->Taken) continue;
+
+		decode->Lump = fileSystem.ReadFile(decode->Image->SourceLump);
+		decode->Done = DecodePool.push([=](int)
+		{
+			try
+			{
+				FileReader lump;
+				lump.OpenMemory(decode->Lump.GetMem(), decode->Lump.GetSize());
+				decode->Pixels.Create(decode->Image->Width, decode->Image->Height);
+				decode->Success = decode->Image->DecodePixels(lump, &decode->Pixels, &decode->TransInfo);
+			}
+			catch (...)
+			{
+				// CopyPixels will run into the same problem and report it.
+				decode->Success = false;
+			}
+		});
+	}
+}
+
+//==========================================================================
+//
+// Moves the decoded image into the precache storage, where GetCachedBitmap
+// finds it.
+//
+//==========================================================================
+
+void FImageSource::FinishDecode(FImageSource *img)
+{
+	auto pindex = precacheDecodeIndex.CheckKey(img->ImageID);
+	if (pindex == nullptr) return;
+
+	unsigned index = *pindex;
+	auto decode = precacheDecodes[index].get();
+	precacheDecodeIndex.Remove(img->ImageID);
+	decode->Taken = true;
+
+	if (decode->Done.valid())
+	{
+		decode->Done.wait();
+		if (decode->Success)
+		{
+			auto info = precacheInfo.CheckKey(img->ImageID);
+			PrecacheDataRgba *pdr = &precacheDataRgba[precacheDataRgba.Reserve(1)];
+			pdr->ImageID = img->ImageID;
+			pdr->RefCount = info != nullptr && info->first > 1 ? info->first : 1;
+			pdr->TransInfo = decode->TransInfo;
+			pdr->Pixels = std::move(decode->Pixels);
+			if (info != nullptr) info->first = 0;
+		}
+		decode->Pixels.Destroy();
+		decode->Lump = FileData();
+	}
+
+	decodeLimit = max(decodeLimit, index + 1 + MaxDecodesAhead);
+	SubmitDecodes();
+}
+
+void FImageSource::ClearDecodes()
+{
+	for (auto &decode : precacheDecodes)
+	{
+		if (decode->Done.valid()) decode->Done.wait();
+	}
+	precacheDecodes.clear();
+	precacheDecodeIndex.Clear();
 }
 
 //==========================================================================
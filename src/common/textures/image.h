@@ -6,6 +6,7 @@
 #include "memarena.h"
 
 class FImageSource;
+class FileReader;
 using PrecacheInfo = TMap<int, std::pair<int, int>>;
 extern FMemArena ImageArena;
 
@@ -108,6 +109,12 @@ public:
 
 	virtual int CopyPixels(FBitmap* bmp, int conversion);
 
+	// Same as CopyPixels with the normal conversion, but reads from the given copy of the lump.
+	// This runs on the precache decoding threads, so only formats that need nothing but their
+	// own lump implement it. Returning false leaves the image to CopyPixels, e.g. to report errors.
+	virtual bool SupportsDecodePixels() { return false; }
+	virtual bool DecodePixels(FileReader &lump, FBitmap *bmp, int *trans) { return false; }
+
 	FBitmap GetCachedBitmap(const PalEntry *remap, int conversion, int *trans = nullptr);
 
 	static void ClearImages() { ImageArena.FreeAll(); ImageForLump.Clear(); NextID = 0; }
@@ -166,6 +173,12 @@ public:
 	static void BeginPrecaching();
 	static void EndPrecaching();
 	static void RegisterForPrecache(FImageSource *img, bool requiretruecolor);
+
+private:
+	static void QueueDecode(FImageSource *img);
+	static void SubmitDecodes();
+	static void FinishDecode(FImageSource *img);
+	static void ClearDecodes();
 };
 
 
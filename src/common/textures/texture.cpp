@@ -57,6 +57,8 @@ IHardwareTexture* CreateHardwareTexture(int numchannels);
 // Make sprite offset adjustment user-configurable per renderer.
 int r_spriteadjustSW, r_spriteadjustHW;
 
+std::recursive_mutex FTexture::LazyDataMutex;
+
 //==========================================================================
 //
 // 
@@ -422,6 +424,14 @@ bool FTexture::DetermineTranslucency()
 	return !!bTranslucent;
 }
 
+bool FTexture::ResolveTranslucency()
+{
+	// Reading the image is not thread safe, so only one caller may do it.
+	std::lock_guard<std::recursive_mutex> lock(LazyDataMutex);
+	if (bTranslucent != -1) return !!bTranslucent;
+	return DetermineTranslucency();
+}
+
 //===========================================================================
 // 
 // the default just returns an empty texture.
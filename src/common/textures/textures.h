@@ -41,6 +41,7 @@
 #include "renderstyle.h"
 #include "textureid.h"
 #include <vector>
+#include <mutex>
 #include "hw_texcontainer.h"
 #include "floatrect.h"
 #include "refcounted.h"
@@ -210,6 +211,8 @@ class FTexture : public RefCountedBase
 
 public:
 	FHardwareTextureContainer SystemTextures;
+	// Guards data that gets calculated on first use, because the hardware renderer's BSP workers can ask for it at the same time.
+	static std::recursive_mutex LazyDataMutex;
 protected:
 	FloatRect* areas = nullptr;
 	int SourceLump;
@@ -288,9 +291,10 @@ public:
 public:
 	FTextureBuffer CreateTexBuffer(int translation, int flags = 0);
 	virtual bool DetermineTranslucency();
+	bool ResolveTranslucency();
 	bool GetTranslucency()
 	{
-		return bTranslucent != -1 ? bTranslucent : DetermineTranslucency();
+		return bTranslucent != -1 ? bTranslucent : ResolveTranslucency();
 	}
 
 public:
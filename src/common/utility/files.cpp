@@ -33,6 +33,16 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "files.h"
 	// just for 'clamp'
 #include "zstring.h"
@@ -314,6 +324,83 @@ char *MemoryReader::Gets(char *strbuf, int len)
 	return strbuf;
 }
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// reads data from a file that is mapped into memory. Since this exposes
+// the data through GetBuffer, uncompressed lumps from such a file are
+// accessed directly through the mapping instead of being copied.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+	void *Mapping = nullptr;
+#ifdef _WIN32
+	HANDLE MapHandle = nullptr;
+#else
+	size_t MappedSize = 0;
+#endif
+
+public:
+	MappedFileReader()
+	{}
+
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (Mapping != nullptr) UnmapViewOfFile(Mapping);
+		if (MapHandle != nullptr) CloseHandle(MapHandle);
+#else
+		if (Mapping != nullptr) munmap(Mapping, MappedSize);
+#endif
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		auto widename = WideString(filename);
+		HANDLE file = CreateFileW(widename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || size.QuadPart > LONG_MAX)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		// The mapping keeps its own reference to the file so the handle is not needed anymore.
+		MapHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (MapHandle == nullptr) return false;
+		Mapping = MapViewOfFile(MapHandle, FILE_MAP_READ, 0, 0, 0);
+		if (Mapping == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || info.st_size > LONG_MAX)
+		{
+			close(fd);
+			return false;
+		}
+		// The mapping stays valid after the descriptor gets closed.
+		void *map = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (map == MAP_FAILED) return false;
+		Mapping = map;
+		MappedSize = (size_t)info.st_size;
+		Length = (long)info.st_size;
+#endif
+		bufptr = (const char *)Mapping;
+		FilePos = 0;
+		return true;
+	}
+};
+
 //==========================================================================
 //
 // MemoryArrayReader
@@ -370,6 +457,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenMappedFile(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
@@ -117,6 +117,7 @@
 #include "screenjob.h"
 #include "startscreen.h"
 #include "shiftstate.h"
+#include "g_benchmark.h"
 
 #ifdef __unix__
 #include "i_system.h"  // for SHARE_DIR
@@ -1138,6 +1139,7 @@ void D_Display ()
 	}
 	cycles.Unclock();
 	FrameCycles = cycles;
+	G_BenchmarkFrame(cycles.TimeMS());
 }
 
 //==========================================================================
@@ -3473,6 +3475,14 @@ static int D_InitGame(const FIWADInfo* iwad_info, TArray<FString>& allwads, TArr
 			v = Args->CheckValue("-timedemo");
 			if (v)
 			{
+				FString *demos;
+				const char *benchfile = Args->CheckValue("-benchmark");
+				int numdemos = Args->CheckParmList("-timedemo", &demos);
+				if (benchfile != nullptr && G_BenchmarkInit(benchfile, demos, numdemos))
+				{
+					// play every demo following -timedemo and record their timings
+					v = demos[0].GetChars();
+				}
 				G_TimeDemo(v);
 			}
 			else
@@ -3754,6 +3764,8 @@ int GameMain()
 
 void D_Cleanup()
 {
+	G_WaitForSave();
+
 	if (demorecording)
 	{
 		G_CheckDemoStatus();
@@ -0,0 +1,279 @@
+/*
+** g_benchmark.cpp
+**
+** Machine readable timedemo results
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+// The #defines here *MUST* match serializer.cpp, or we will get countless strange errors.
+#define RAPIDJSON_48BITPOINTER_OPTIMIZATION 0	// disable this insanity which is bound to make the code break over time.
+#define RAPIDJSON_HAS_CXX11_RVALUE_REFS 1
+#define RAPIDJSON_HAS_CXX11_RANGE_FOR 1
+#define RAPIDJSON_PARSE_DEFAULT_FLAGS kParseFullPrecisionFlag
+
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "g_benchmark.h"
+#include "stats.h"
+#include "i_time.h"
+#include "files.h"
+#include "filesystem.h"
+#include "version.h"
+#include "printf.h"
+
+extern cycle_t ThinkCycles, ActionCycles, ACSTime, SightCycles;
+extern bool timingdemo;
+
+struct FBenchmarkDemo
+{
+	FString Name;
+	int StartTic = -1;
+	int GameTics = 0;
+	uint64_t StartTime = 0;
+	double RealTimeMS = 0;
+
+	TArray<double> Playsim;
+	TArray<double> Think;
+	TArray<double> Action;
+	TArray<double> ACS;
+	TArray<double> Sight;
+	TArray<double> Render;
+};
+
+static FString BenchmarkFile;
+static TArray<FString> BenchmarkDemos;
+static TArray<FBenchmarkDemo> BenchmarkResults;
+static bool BenchmarkActive;
+
+using BenchmarkWriter = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
+
+//==========================================================================
+//
+// Sets up the demo queue. The caller starts the first demo.
+//
+//==========================================================================
+
+bool G_BenchmarkInit(const char *outfile, FString *demos, int numdemos)
+{
+	if (numdemos <= 0)
+	{
+		Printf("-benchmark requires at least one demo passed with -timedemo\n");
+		return false;
+	}
+
+	BenchmarkFile = outfile;
+	BenchmarkDemos.Clear();
+	for (int i = 0; i < numdemos; i++)
+	{
+		BenchmarkDemos.Push(demos[i]);
+	}
+	BenchmarkResults.Clear();
+	BenchmarkResults.Reserve(1);
+	BenchmarkResults.Last().Name = BenchmarkDemos[0];
+	BenchmarkActive = true;
+	return true;
+}
+
+bool G_BenchmarkActive()
+{
+	return BenchmarkActive;
+}
+
+//==========================================================================
+//
+// Called after every playsim tic. The thinker, ACS and sight counters
+// are reset by the playsim at the start of each tic, so at this point
+// they contain this tic's time.
+//
+//==========================================================================
+
+void G_BenchmarkTic(double playsimms)
+{
+	if (!BenchmarkActive || !demoplayback || !timingdemo)
+		return;
+
+	auto &demo = BenchmarkResults.Last();
+	if (demo.StartTic < 0)
+	{
+		demo.StartTic = gametic;
+		demo.StartTime = I_nsTime();
+	}
+	demo.Playsim.Push(playsimms);
+	demo.Think.Push(ThinkCycles.TimeMS());
+	demo.Action.Push(ActionCycles.TimeMS());
+	demo.ACS.Push(ACSTime.TimeMS());
+	demo.Sight.Push(SightCycles.TimeMS());
+}
+
+void G_BenchmarkFrame(double renderms)
+{
+	if (!BenchmarkActive || !demoplayback || !timingdemo)
+		return;
+
+	auto &demo = BenchmarkResults.Last();
+	if (demo.StartTic >= 0)
+	{
+		demo.Render.Push(renderms);
+	}
+}
+
+//==========================================================================
+//
+// Percentiles use the nearest rank of the sorted samples
+//
+//==========================================================================
+
+static double Percentile(const TArray<double> &sorted, double p)
+{
+	if (sorted.Size() == 0)
+		return 0;
+	unsigned rank = unsigned(ceil(p * sorted.Size()));
+	return sorted[clamp(rank, 1u, sorted.Size()) - 1];
+}
+
+static void WriteSeries(BenchmarkWriter &w, const char *name, const TArray<double> &samples)
+{
+	TArray<double> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0;
+	for (auto s : samples) total += s;
+
+	w.Key(name);
+	w.StartObject();
+	w.Key("count");
+	w.Uint(samples.Size());
+	w.Key("total");
+	w.Double(total);
+	w.Key("mean");
+	w.Double(samples.Size() > 0 ? total / samples.Size() : 0.);
+	w.Key("p50");
+	w.Double(Percentile(sorted, 0.5));
+	w.Key("p99");
+	w.Double(Percentile(sorted, 0.99));
+	w.Key("max");
+	w.Double(sorted.Size() > 0 ? sorted.Last() : 0.);
+	w.Key("samples");
+	w.StartArray();
+	for (auto s : samples) w.Double(s);
+	w.EndArray();
+	w.EndObject();
+}
+
+static void WriteBenchmarkFile()
+{
+	rapidjson::StringBuffer buffer;
+	BenchmarkWriter w(buffer);
+	w.SetMaxDecimalPlaces(4);
+
+	w.StartObject();
+	w.Key("engine");
+	w.String(GetVersionString());
+	w.Key("nodraw");
+	w.Bool(nodrawers);
+	w.Key("files");
+	w.StartArray();
+	for (int i = 0; i < fileSystem.GetNumWads(); i++)
+	{
+		w.String(fileSystem.GetResourceFileName(i));
+	}
+	w.EndArray();
+
+	w.Key("demos");
+	w.StartArray();
+	for (auto &demo : BenchmarkResults)
+	{
+		w.StartObject();
+		w.Key("name");
+		w.String(demo.Name.GetChars());
+		w.Key("gametics");
+		w.Int(demo.GameTics);
+		w.Key("realtime_ms");
+		w.Double(demo.RealTimeMS);
+		w.Key("fps");
+		w.Double(demo.RealTimeMS > 0 ? demo.Render.Size() * 1000. / demo.RealTimeMS : 0.);
+		w.Key("units");
+		w.String("ms");
+		WriteSeries(w, "playsim", demo.Playsim);
+		WriteSeries(w, "think", demo.Think);
+		WriteSeries(w, "action", demo.Action);
+		WriteSeries(w, "acs", demo.ACS);
+		WriteSeries(w, "sight", demo.Sight);
+		WriteSeries(w, "render", demo.Render);
+		w.EndObject();
+	}
+	w.EndArray();
+	w.EndObject();
+
+	auto fw = FileWriter::Open(BenchmarkFile);
+	if (fw == nullptr)
+	{
+		Printf("Unable to open %s for writing\n", BenchmarkFile.GetChars());
+		return;
+	}
+	fw->Write(buffer.GetString(), buffer.GetSize());
+	delete fw;
+	Printf("Benchmark results written to %s\n", BenchmarkFile.GetChars());
+}
+
+//==========================================================================
+//
+// Called from G_CheckDemoStatus when a timed demo ends. Returns true
+// if the next queued demo has been started, false once all are done
+// and the results have been written.
+//
+//==========================================================================
+
+bool G_BenchmarkDemoFinished(const char *demoname)
+{
+	auto &demo = BenchmarkResults.Last();
+	if (demo.StartTic >= 0)
+	{
+		demo.GameTics = gametic - demo.StartTic;
+		demo.RealTimeMS = (I_nsTime() - demo.StartTime) * 1e-6;
+	}
+	Printf("%s: timed %i gametics in %.1f ms\n", demoname, demo.GameTics, demo.RealTimeMS);
+
+	if (BenchmarkResults.Size() < BenchmarkDemos.Size())
+	{
+		BenchmarkResults.Reserve(1);
+		BenchmarkResults.Last().Name = BenchmarkDemos[BenchmarkResults.Size() - 1];
+		G_TimeDemo(BenchmarkDemos[BenchmarkResults.Size() - 1].GetChars());
+		return true;
+	}
+
+	WriteBenchmarkFile();
+	BenchmarkActive = false;
+	return false;
+}
@@ -0,0 +1,16 @@
+#ifndef __G_BENCHMARK_H
+#define __G_BENCHMARK_H
+
+class FString;
+
+// Demo benchmark harness. Started with -benchmark <file.json> together with
+// -timedemo <demo> [demo...]; every listed demo is played with the usual
+// timedemo settings and the collected timings are written as JSON.
+
+bool G_BenchmarkInit(const char *outfile, FString *demos, int numdemos);
+bool G_BenchmarkActive();
+void G_BenchmarkTic(double playsimms);
+void G_BenchmarkFrame(double renderms);
+bool G_BenchmarkDemoFinished(const char *demoname);
+
+#endif
@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <memory>
+#include <thread>
+#include <atomic>
 
 #include "i_time.h"
 
@@ -90,6 +92,8 @@
 #include "doommenu.h"
 #include "screenjob.h"
 #include "i_interface.h"
+#include "g_benchmark.h"
+#include "stats.h"
 
 
 static FRandom pr_dmspawn ("DMSpawn");
@@ -115,11 +119,13 @@ bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompress
 
 CVARD_NAMED(Int, gameskill, skill, 2, CVAR_SERVERINFO|CVAR_LATCH, "sets the skill for the next newly started game")
 CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_json, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// write the level and global data as JSON instead of the binary format.
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, longsavemessages, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, save_async, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// compress and write savegames on a background thread
 CVAR (Bool, enablescriptscreenshot, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 EXTERN_CVAR (Float, con_midtime);
 
@@ -1106,6 +1112,8 @@ void G_Ticker ()
 	int i;
 	gamestate_t	oldgamestate;
 
+	G_CheckSaveFinished();
+
 	// do player reborns if needed
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -1287,9 +1295,15 @@ void G_Ticker ()
 	switch (gamestate)
 	{
 	case GS_LEVEL:
+	{
+		cycle_t playsim;
+		playsim.ResetAndClock();
 		P_Ticker ();
+		playsim.Unclock();
+		G_BenchmarkTic(playsim.TimeMS());
 		primaryLevel->automap->Ticker ();
 		break;
+	}
 
 	case GS_TITLELEVEL:
 		P_Ticker ();
@@ -1974,6 +1988,9 @@ void G_DoLoadGame ()
 	hidecon = gameaction == ga_loadgamehidecon;
 	gameaction = ga_nothing;
 
+	// The file to load may still be in the process of being written.
+	G_WaitForSave();
+
 	std::unique_ptr<FResourceFile> resfile(FResourceFile::OpenResourceFile(savename.GetChars(), true, true));
 	if (resfile == nullptr)
 	{
@@ -2309,6 +2326,140 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
+//==========================================================================
+//
+// Savegames are written in two stages. The game state gets serialized on
+// the game thread into uncompressed buffers which are then handed off to
+// a job that compresses them and writes the zip, by default on its own
+// thread so that the game does not need to wait for it.
+//
+//==========================================================================
+
+struct FSaveGameJob
+{
+	FString Filename;
+	FString Description;
+	bool OkForQuicksave;
+	bool ForceQuicksave;
+	bool Threaded;
+	bool Written;
+
+	TArray<FString> Filenames;
+	TArray<FCompressedBuffer> Content;	// all buffers are owned by the job
+	TArray<bool> Compress;
+
+	uint64_t StartTime;
+	uint64_t StallTime;
+	uint64_t EndTime;
+
+	std::thread Thread;
+	std::atomic<bool> Done;
+
+	~FSaveGameJob()
+	{
+		for (auto &buff : Content) buff.Clean();
+	}
+};
+
+static std::unique_ptr<FSaveGameJob> SaveJob;
+static uint64_t LastSaveStall, LastSaveTotal;
+static bool LastSaveThreaded;
+
+static void RunSaveGameJob(FSaveGameJob *job)
+{
+	for (unsigned i = 0; i < job->Content.Size(); i++)
+	{
+		if (job->Compress[i]) job->Content[i].Compress();
+	}
+	job->Written = WriteZip(job->Filename, job->Filenames, job->Content);
+	job->EndTime = I_nsTime();
+	job->Done = true;
+}
+
+static void FinishSaveGame()
+{
+	auto job = SaveJob.get();
+	if (job->Thread.joinable()) job->Thread.join();
+
+	bool succeeded = false;
+	if (job->Written)
+	{
+		// Check whether the file is ok by trying to open it.
+		FResourceFile *test = FResourceFile::OpenResourceFile(job->Filename, true);
+		if (test != nullptr)
+		{
+			delete test;
+			succeeded = true;
+		}
+	}
+
+	if (succeeded)
+	{
+		savegameManager.NotifyNewSave(job->Filename, job->Description, job->OkForQuicksave, job->ForceQuicksave);
+		BackupSaveName = job->Filename;
+
+		if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), job->Filename.GetChars());
+		else Printf("%s\n", GStrings("GGSAVED"));
+	}
+	else
+	{
+		Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
+	}
+
+	LastSaveTotal = job->EndTime - job->StartTime;
+	LastSaveStall = job->Threaded ? job->StallTime : LastSaveTotal;
+	LastSaveThreaded = job->Threaded;
+	SaveJob.reset();
+}
+
+//==========================================================================
+//
+// Called every tic to report a save that has been written in the background.
+//
+//==========================================================================
+
+void G_CheckSaveFinished()
+{
+	if (SaveJob != nullptr && SaveJob->Done)
+	{
+		FinishSaveGame();
+	}
+}
+
+//==========================================================================
+//
+// Blocks until a pending save has been written. Needed before anything
+// that may access the file or that must not leave it incomplete.
+//
+//==========================================================================
+
+void G_WaitForSave()
+{
+	if (SaveJob != nullptr)
+	{
+		FinishSaveGame();
+	}
+}
+
+ADD_STAT(savegame)
+{
+	FString out;
+	if (SaveJob != nullptr)
+	{
+		out.Format("Writing %s", SaveJob->Filename.GetChars());
+	}
+	else if (LastSaveTotal == 0)
+	{
+		out = "No savegame written";
+	}
+	else
+	{
+		out.Format("Last save: game thread %.2f ms, total %.2f ms (%s)",
+			LastSaveStall * 1e-6, LastSaveTotal * 1e-6, LastSaveThreaded ? "async" : "sync");
+	}
+	return out;
+}
+
 void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, const char *description)
 {
 	TArray<FCompressedBuffer> savegame_content;
@@ -2328,13 +2479,18 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 		filename = G_BuildSaveName ("demosave");
 	}
 
+	uint64_t starttime = I_nsTime();
+
+	// Only one save can be in flight at a time.
+	G_WaitForSave();
+
 	if (cl_waitforsave)
 		I_FreezeTime(true);
 
 	insave = true;
 	try
 	{
-		level.SnapshotLevel();
+		level.SnapshotLevel(false);
 	}
 	catch(CRecoverableError &err)
 	{
@@ -2361,7 +2517,7 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	FSerializer savegameglobals;	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	savegameglobals.OpenWriter(save_formatted, !save_formatted && !save_json);
 
 	SaveVersion = SAVEVER;
 	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
@@ -2407,57 +2563,71 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	}
 
 	auto picdata = savepic.GetBuffer();
-	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), (char*)&(*picdata)[0] };
+	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), new char[picdata->Size()] };
+	memcpy(bufpng.mBuffer, &(*picdata)[0], picdata->Size());
 
 	savegame_content.Push(bufpng);
 	savegame_filenames.Push("savepic.png");
-	savegame_content.Push(savegameinfo.GetCompressedOutput());
+	savegame_content.Push(savegameinfo.GetStoredOutput());
 	savegame_filenames.Push("info.json");
-	savegame_content.Push(savegameglobals.GetCompressedOutput());
+	savegame_content.Push(savegameglobals.GetStoredOutput());
 	savegame_filenames.Push("globals.json");
 
-	G_WriteSnapshots (savegame_filenames, savegame_content);
-	
+	auto job = new FSaveGameJob;
+	SaveJob.reset(job);
+	job->Compress.Push(false);
+	job->Compress.Push(true);
+	job->Compress.Push(true);
 
-	bool succeeded = false;
+	G_WriteSnapshots (savegame_filenames, savegame_content);
 
-	if (WriteZip(filename, savegame_filenames, savegame_content))
+	// The current level's snapshot is not needed any longer so the job
+	// can take it over. Other levels' snapshots may be discarded while the
+	// job is still running so it gets its own copy of those.
+	for (unsigned i = job->Compress.Size(); i < savegame_content.Size(); i++)
 	{
-		// Check whether the file is ok by trying to open it.
-		FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
-		if (test != nullptr)
+		auto &buff = savegame_content[i];
+		if (buff.mBuffer == level.info->Snapshot.mBuffer)
 		{
-			delete test;
-			succeeded = true;
+			level.info->Snapshot.mBuffer = nullptr;
+			job->Compress.Push(true);
+		}
+		else
+		{
+			char *copy = new char[buff.mCompressedSize];
+			memcpy(copy, buff.mBuffer, buff.mCompressedSize);
+			buff.mBuffer = copy;
+			job->Compress.Push(false);
 		}
 	}
+	level.info->Snapshot.Clean();
 
-	if (succeeded)
-	{
-		savegameManager.NotifyNewSave(filename, description, okForQuicksave, forceQuicksave);
-		BackupSaveName = filename;
-
-		if (longsavemessages) Printf("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
-		else Printf("%s\n", GStrings("GGSAVED"));
-	}
-	else
-	{
-		Printf(PRINT_HIGH, "%s\n", GStrings("TXT_SAVEFAILED"));
-	}
-
-
-	// delete the JSON buffers we created just above. Everything else will
-	// either still be needed or taken care of automatically.
-	savegame_content[1].Clean();
-	savegame_content[2].Clean();
+	job->Filename = filename;
+	job->Description = description;
+	job->OkForQuicksave = okForQuicksave;
+	job->ForceQuicksave = forceQuicksave;
+	job->Filenames = std::move(savegame_filenames);
+	job->Content = std::move(savegame_content);
+	job->Written = false;
+	job->Done = false;
+	job->StartTime = starttime;
+	job->StallTime = I_nsTime() - starttime;
+	job->Threaded = save_async;
 
-	// We don't need the snapshot any longer.
-	level.info->Snapshot.Clean();
-		
 	insave = false;
 
 	if (cl_waitforsave)
 		I_FreezeTime(false);
+
+	if (job->Threaded)
+	{
+		job->Thread = std::thread(RunSaveGameJob, job);
+	}
+	else
+	{
+		RunSaveGameJob(job);
+		FinishSaveGame();
+	}
 }
 
 
@@ -2993,6 +3163,15 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+				if (G_BenchmarkActive())
+				{
+					if (G_BenchmarkDemoFinished(defdemoname.GetChars()))
+					{
+						return true;
+					}
+					throw CExitEvent(0);
+				}
+
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
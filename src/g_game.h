@@ -63,6 +63,9 @@ void G_DoLoadGame (void);
 
 // Called by M_Responder.
 void G_SaveGame (const char *filename, const char *description);
+// Savegames get written in the background.
+void G_CheckSaveFinished ();
+void G_WaitForSave ();
 // Called by messagebox
 void G_DoQuickSave ();
 
@@ -89,6 +89,47 @@ struct FPortalBits
 	}
 };
 
+//============================================================================
+//
+// The render subsectors' edges as inward facing planes, stored as
+// structure of arrays so that testing a point against them is a tight loop.
+// Node partitions that might not agree with the edges are included as well,
+// so if a point is inside by at least MARGIN, the BSP can only lead to this
+// subsector. Subsectors that are not closed and convex have no planes and
+// never contain anything.
+//
+//============================================================================
+
+struct FSubsectorHulls
+{
+	static constexpr double MARGIN = 1. / 4;
+
+	TArray<unsigned> first;		// one more entry than there are subsectors
+	TArray<double> nx;
+	TArray<double> ny;
+	TArray<double> dist;
+
+	void Clear()
+	{
+		first.Clear();
+		nx.Clear();
+		ny.Clear();
+		dist.Clear();
+	}
+
+	bool Contains(unsigned index, const DVector2 &pos) const
+	{
+		if (index + 1 >= first.Size() || first[index] == first[index + 1]) return false;
+
+		bool inside = true;
+		for (unsigned i = first[index]; i < first[index + 1]; i++)
+		{
+			inside &= nx[i] * pos.X + ny[i] * pos.Y - dist[i] >= MARGIN;
+		}
+		return inside;
+	}
+};
+
 class DACSThinker;
 class DFraggleThinker;
 class DSpotState;
@@ -172,7 +213,7 @@ private:
 	void PlayerSpawnPickClass (int playernum);
 
 public:
-	void SnapshotLevel();
+	void SnapshotLevel(bool compress = true);
 	void UnSnapshotLevel(bool hubLoad);
 
 	void FinalizePortals();
@@ -384,6 +425,16 @@ public:
 		return PointInSubsector(x, y)->sector;
 	}
 
+	// Same result as PointInSector, but does not need to walk the BSP if the point is inside the given render subsector.
+	sector_t *PointInSector(const DVector2 &pos, const subsector_t *hint)
+	{
+		if (hint != nullptr && gamenodes.Size() == 0 && subsectorhulls.Contains(hint->Index(), pos))
+		{
+			return hint->sector;
+		}
+		return PointInSubsector(pos.X, pos.Y)->sector;
+	}
+
 	subsector_t *PointInRenderSubsector (const DVector2 &pos)
 	{
 		return PointInRenderSubsector(FloatToFixed(pos.X), FloatToFixed(pos.Y));
@@ -412,6 +463,18 @@ public:
 		return true;
 	}
 
+	// Like the reject matrix, but with each row padded to whole bytes. This is
+	// only valid for sight checks between points inside their subsectors, see P_CheckSight.
+	bool CheckSightPVS(sector_t *s1, sector_t *s2)
+	{
+		if (sightpvs.Size() > 0)
+		{
+			int s2num = s2->Index();
+			return !(sightpvs[s1->Index() * ((sectors.Size() + 7) >> 3) + (s2num >> 3)] & (1 << (s2num & 7)));
+		}
+		return true;
+	}
+
 	DThinker *CreateThinker(PClass *cls, int statnum = STAT_DEFAULT)
 	{
 		DThinker *thinker = static_cast<DThinker*>(cls->CreateNew());
@@ -447,6 +510,8 @@ public:
 	TArray<node_t> gamenodes;
 	node_t *headgamenode;
 	TArray<uint8_t> rejectmatrix;
+	TArray<uint8_t> sightpvs;
+	FSubsectorHulls subsectorhulls;
 	TArray<zone_t>	Zones;
 	TArray<FPolyObj> Polyobjects;
 
@@ -658,7 +723,7 @@ public:
 	uint32_t			ActiveParticles;
 	uint32_t			InactiveParticles;
 	TArray<particle_t>	Particles;
-	TArray<uint16_t>	ParticlesInSubsec;
+	TArray<uint32_t>	ParticlesInSubsec;
 	FThinkerCollection Thinkers;
 
 	TArray<DVector2>	Scrolls;		// NULL if no DScrollers in this level
@@ -2936,6 +2936,136 @@ void MapLoader::CalcIndices()
 	}
 }
 
+//==========================================================================
+//
+// Stores the subsector edges as planes for FSubsectorHulls::Contains.
+// This must be done before the polyobjects are moved to their start spots
+// because it has to match the geometry the nodes were built from.
+//
+// The partition lines of the nodes need not pass exactly through the
+// subsectors' edges, e.g. GL v2/v5 and XGLN nodes only store them with
+// integer precision. Every partition above a subsector that does not
+// provably agree with its edges is added as another plane, using the same
+// side test as R_PointOnSide, so that the BSP walk can never end somewhere
+// else for a point that passes all planes.
+//
+//==========================================================================
+
+void MapLoader::BuildSubsectorHulls()
+{
+	auto &hulls = Level->subsectorhulls;
+	hulls.Clear();
+	hulls.first.Resize(Level->subsectors.Size() + 1);
+
+	// For every node and subsector the node and side it hangs off, as node * 2 + side, or -1 for the root.
+	TArray<int> nodeparent, subparent;
+	nodeparent.Resize(Level->nodes.Size());
+	subparent.Resize(Level->subsectors.Size());
+	for (auto &p : nodeparent) p = -1;
+	for (auto &p : subparent) p = -1;
+	for (unsigned i = 0; i < Level->nodes.Size(); i++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			void *child = Level->nodes[i].children[side];
+			if ((size_t)child & 1) subparent[((subsector_t *)((uint8_t *)child - 1))->Index()] = i * 2 + side;
+			else nodeparent[(node_t *)child - &Level->nodes[0]] = i * 2 + side;
+		}
+	}
+
+	for (auto &sub : Level->subsectors)
+	{
+		unsigned start = hulls.nx.Size();
+		hulls.first[sub.Index()] = start;
+
+		bool valid = sub.numlines >= 3;
+		for (uint32_t i = 0; i < sub.numlines && valid; i++)
+		{
+			seg_t *seg = &sub.firstline[i];
+			DVector2 v1 = seg->v1->fPos();
+			DVector2 d = seg->v2->fPos() - v1;
+			double len = d.Length();
+
+			// the segs must form a closed loop with the inside on their right.
+			if (len < EQUAL_EPSILON || seg->v2->fPos() != sub.firstline[(i + 1) % sub.numlines].v1->fPos())
+			{
+				valid = false;
+				break;
+			}
+			double nx = d.Y / len, ny = -d.X / len, dist = nx * v1.X + ny * v1.Y;
+			for (uint32_t j = 0; j < sub.numlines; j++)
+			{
+				if (nx * sub.firstline[j].v1->fX() + ny * sub.firstline[j].v1->fY() - dist < -EQUAL_EPSILON)
+				{
+					valid = false;
+					break;
+				}
+			}
+			hulls.nx.Push(nx);
+			hulls.ny.Push(ny);
+			hulls.dist.Push(dist);
+		}
+
+		for (int parent = subparent[sub.Index()]; parent >= 0 && valid; parent = nodeparent[parent >> 1])
+		{
+			const node_t *node = &Level->nodes[parent >> 1];
+			double x = FIXED2DBL(node->x), y = FIXED2DBL(node->y);
+			double dx = FIXED2DBL(node->dx), dy = FIXED2DBL(node->dy);
+			double len = sqrt(dx * dx + dy * dy);
+			if (len == 0)
+			{
+				// R_PointOnSide always returns 0 for this.
+				valid = !(parent & 1);
+				continue;
+			}
+
+			// R_PointOnSide returns 1 if dx * (py - y) - dy * (px - x) >= 1.
+			double nx, ny, dist;
+			if (parent & 1)
+			{
+				nx = -dy / len, ny = dx / len, dist = (1 + dx * y - dy * x) / len;
+			}
+			else
+			{
+				nx = dy / len, ny = -dx / len, dist = (dy * x - dx * y - 1) / len;
+			}
+
+			// A point that passes the edge planes lies within the corners and at least MARGIN
+			// inside each edge. Each of these gives a lower bound for the point's distance
+			// from the partition, and the plane is only needed if none of them is positive.
+			// For a partition that exactly continues an edge the bound from that edge is
+			// MARGIN -/+ 1 / len, so such partitions only get added when they are short.
+			double bound = -DBL_MAX;
+			for (uint32_t i = 0; i <= sub.numlines; i++)
+			{
+				double mindist = DBL_MAX;
+				for (uint32_t j = 0; j < sub.numlines; j++)
+				{
+					DVector2 v = sub.firstline[j].v1->fPos();
+					double d = nx * v.X + ny * v.Y - dist;
+					if (i < sub.numlines) d -= hulls.nx[start + i] * v.X + hulls.ny[start + i] * v.Y - hulls.dist[start + i];
+					mindist = min(mindist, d);
+				}
+				bound = max(bound, mindist + (i < sub.numlines ? FSubsectorHulls::MARGIN : 0));
+			}
+			if (bound < 1. / 64)
+			{
+				hulls.nx.Push(nx);
+				hulls.ny.Push(ny);
+				hulls.dist.Push(dist);
+			}
+		}
+
+		if (!valid)
+		{
+			hulls.nx.Resize(start);
+			hulls.ny.Resize(start);
+			hulls.dist.Resize(start);
+		}
+	}
+	hulls.first.Last() = hulls.nx.Size();
+}
+
 //==========================================================================
 //
 //
@@ -3189,6 +3319,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 
 	// Create the item indices, after the last function which may change the data has run.
 	CalcIndices();
+	BuildSubsectorHulls();
 
 	Level->bodyqueslot = 0;
 	// phares 8/10/98: Clear body queue so the corpses from previous games are
@@ -3264,6 +3395,7 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	PO_Init();				// Initialize the polyobjs
 	if (!Level->IsReentering())
 		Level->FinalizePortals();	// finalize line portals after polyobjects have been initialized. This info is needed for properly flagging them.
+	BuildSightPVS(map);
 
 	Level->aabbTree = new DoomLevelAABBTree(Level);
 	Level->levelMesh = new DoomLevelMesh(*Level);
@@ -7,6 +7,9 @@ class FileReader;
 struct FStrifeDialogueNode;
 struct FStrifeDialogueReply;
 struct Response;
+struct MapData;
+
+FString CreateCacheName(MapData *map, bool create, const char *extension = ".gzc");
 
 struct EDMapthing
 {
@@ -179,6 +182,7 @@ private:
 	void FixHoles();
 	void ReportUnpairedMinisegs();
 	void CalcIndices();
+	void BuildSubsectorHulls();
 	
 	// Strife dialogue
 	void LoadStrifeConversations (MapData *map, const char *mapname);
@@ -307,6 +311,7 @@ public:
 	void SetSubsectorLightmap(const LightmapSurface &surface);
 	void SetSideLightmap(const LightmapSurface &surface);
 	void LoadLightmap(MapData *map);
+	void BuildSightPVS(MapData *map);
 
 	void LoadLevel(MapData *map, const char *lumpname, int position);
 
@@ -0,0 +1,501 @@
+/*
+** sightpvs.cpp
+**
+** Sector to sector visibility for P_CheckSight
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The matrix built here works like the REJECT lump (with each row padded to
+** whole bytes), but unlike REJECT it is computed from the GL subsectors: a bit is set if no straight
+** line from anywhere inside one sector to anywhere inside the other can get
+** past the one-sided walls in between. Since every sight trace that crosses
+** a one-sided line fails, this can reject a sight check without walking the
+** blockmap, provided both ends of the trace are inside a subsector of their
+** sector. P_CheckSight verifies that before using it.
+**
+** The visibility is found by flowing through the subsector portals (minisegs
+** and two-sided lines), clipping each portal against the separating lines of
+** the source portal and the portal it was entered through. All clipping is
+** done with some slack, so rounding can only ever make more sectors visible.
+**
+*/
+
+#include <zlib.h>
+
+#include "c_cvars.h"
+#include "filesystem.h"
+#include "p_setup.h"
+#include "g_levellocals.h"
+#include "i_time.h"
+#include "printf.h"
+#include "files.h"
+#include "maploader.h"
+#include "ctpl.h"
+
+CVAR(Bool, p_sightpvs, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+EXTERN_CVAR(Bool, gl_cachenodes)
+EXTERN_CVAR(Float, gl_cachetime)
+
+static const double PVS_EPSILON = 1. / 4;		// slack for all portal clipping.
+static const int PVS_MAXSECTORS = 16384;		// 32 MB worth of matrix.
+static const int PVS_MAXFLOWSTEPS = 4096;		// per source subsector, before it is assumed to see everything.
+static const int PVS_MAXFLOWDEPTH = 512;		// keeps the recursion within the worker threads' stacks.
+static const uint32_t PVS_VERSION = 1;
+
+struct FPVSWinding
+{
+	DVector2 a, b;
+};
+
+struct FPVSPortal
+{
+	FPVSWinding w;
+	int to;
+};
+
+struct FPVSSubsector
+{
+	unsigned firstportal;
+	unsigned numportals;
+	int sector;
+};
+
+//==========================================================================
+//
+// A private copy of the map's subsector graph, so that the worker threads
+// do not have to touch any level data.
+//
+//==========================================================================
+
+struct FSightPVSBuilder
+{
+	TArray<FPVSSubsector> Subsectors;
+	TArray<FPVSPortal> Portals;
+	TArray<TArray<int>> SectorSubsectors;
+	int NumSectors;
+	unsigned RowBytes;
+	TArray<uint8_t> Visible;		// one bit per visible sector pair
+
+	bool Setup(FLevelLocals *Level);
+	void BuildSector(int sector, TArray<uint8_t> &onstack);
+};
+
+struct FPVSFlow
+{
+	FSightPVSBuilder *builder;
+	uint8_t *row;
+	uint8_t *onstack;
+	int steps;
+	int depth;
+	bool overflow;
+
+	void Mark(int subsector)
+	{
+		int sec = builder->Subsectors[subsector].sector;
+		row[sec >> 3] |= 1 << (sec & 7);
+	}
+
+	void Flow(int subsector, const FPVSWinding &source, const FPVSWinding &pass);
+};
+
+static inline double Cross(const DVector2 &a, const DVector2 &b)
+{
+	return a.X * b.Y - a.Y * b.X;
+}
+
+//==========================================================================
+//
+// Clips a winding to the side of the line through p1 and p2 that has the
+// sign of 'sidedist'. Returns false if nothing is left.
+//
+//==========================================================================
+
+static bool ClipWinding(FPVSWinding &w, const DVector2 &p1, const DVector2 &p2, double sidedist)
+{
+	DVector2 d = p2 - p1;
+	double len = d.Length();
+	if (len < PVS_EPSILON) return true;	// too short to define a line.
+
+	double s = sidedist > 0 ? 1. / len : -1. / len;
+	double d1 = Cross(w.a - p1, d) * s;
+	double d2 = Cross(w.b - p1, d) * s;
+	if (d1 < -PVS_EPSILON && d2 < -PVS_EPSILON) return false;
+	if (d1 < -PVS_EPSILON)
+	{
+		w.a += (w.b - w.a) * ((d1 + PVS_EPSILON) / (d1 - d2));
+	}
+	else if (d2 < -PVS_EPSILON)
+	{
+		w.b += (w.a - w.b) * ((d2 + PVS_EPSILON) / (d2 - d1));
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Clips a winding to the area that can be seen from 'source' through
+// 'pass'. These are bounded by the lines which touch an end point of both
+// and have the two windings on opposite sides.
+//
+//==========================================================================
+
+static bool ClipToSeparators(const FPVSWinding &source, const FPVSWinding &pass, FPVSWinding &w)
+{
+	const DVector2 *s[2] = { &source.a, &source.b };
+	const DVector2 *p[2] = { &pass.a, &pass.b };
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			DVector2 d = *p[j] - *s[i];
+			double len = d.Length();
+			if (len < PVS_EPSILON) continue;
+
+			double ds = Cross(*s[1 - i] - *s[i], d) / len;
+			double dp = Cross(*p[1 - j] - *s[i], d) / len;
+			// ambiguous lines are skipped, that only makes the result larger.
+			if (fabs(ds) < PVS_EPSILON || fabs(dp) < PVS_EPSILON || (ds > 0) == (dp > 0)) continue;
+
+			if (!ClipWinding(w, *s[i], *p[j], dp)) return false;
+		}
+	}
+	return true;
+}
+
+void FPVSFlow::Flow(int subsector, const FPVSWinding &source, const FPVSWinding &pass)
+{
+	if (++steps > PVS_MAXFLOWSTEPS || depth >= PVS_MAXFLOWDEPTH)
+	{
+		overflow = true;
+		return;
+	}
+
+	// a straight line can pass through each convex subsector only once.
+	onstack[subsector] = true;
+	auto &sub = builder->Subsectors[subsector];
+	for (unsigned i = 0; i < sub.numportals && !overflow; i++)
+	{
+		auto &portal = builder->Portals[sub.firstportal + i];
+		if (onstack[portal.to]) continue;
+
+		FPVSWinding next = portal.w;
+		if (!ClipToSeparators(source, pass, next)) continue;
+
+		FPVSWinding nextsource = source;
+		if (!ClipToSeparators(next, pass, nextsource)) continue;
+
+		Mark(portal.to);
+		depth++;
+		Flow(portal.to, nextsource, next);
+		depth--;
+	}
+	onstack[subsector] = false;
+}
+
+//==========================================================================
+//
+// Copies the subsector graph. Returns false if the map's nodes cannot be
+// trusted to describe its open space, i.e. non-convex or unclosed
+// subsectors, or see-through segs without a partner.
+//
+//==========================================================================
+
+bool FSightPVSBuilder::Setup(FLevelLocals *Level)
+{
+	NumSectors = Level->sectors.Size();
+	RowBytes = (NumSectors + 7) / 8;
+	Subsectors.Resize(Level->subsectors.Size());
+	SectorSubsectors.Resize(NumSectors);
+
+	for (auto &sub : Level->subsectors)
+	{
+		auto &pvssub = Subsectors[sub.Index()];
+		pvssub.sector = sub.sector->Index();
+		pvssub.firstportal = Portals.Size();
+		SectorSubsectors[pvssub.sector].Push(sub.Index());
+
+		for (uint32_t i = 0; i < sub.numlines; i++)
+		{
+			seg_t *seg = &sub.firstline[i];
+			seg_t *nextseg = &sub.firstline[(i + 1) % sub.numlines];
+			DVector2 v1 = seg->v1->fPos(), v2 = seg->v2->fPos();
+			DVector2 d = v2 - v1;
+			double len = d.Length();
+
+			if ((nextseg->v1->fPos() - v2).LengthSquared() > PVS_EPSILON * PVS_EPSILON)
+				return false;
+
+			for (uint32_t j = 0; j < sub.numlines; j++)
+			{
+				if (Cross(sub.firstline[j].v1->fPos() - v1, d) < -PVS_EPSILON * len)
+					return false;
+			}
+
+			if (seg->linedef == nullptr || seg->linedef->backsector != nullptr)
+			{
+				if (seg->PartnerSeg == nullptr || seg->PartnerSeg->Subsector == nullptr)
+					return false;
+
+				if (len < 1e-6) continue;
+				d *= PVS_EPSILON / len;
+				Portals.Push({ { v1 - d, v2 + d }, seg->PartnerSeg->Subsector->Index() });
+			}
+		}
+		pvssub.numportals = Portals.Size() - pvssub.firstportal;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Fills the matrix row of one sector. Each job only writes its own row.
+//
+//==========================================================================
+
+void FSightPVSBuilder::BuildSector(int sector, TArray<uint8_t> &onstack)
+{
+	uint8_t *row = &Visible[sector * RowBytes];
+	row[sector >> 3] |= 1 << (sector & 7);
+
+	for (auto subsector : SectorSubsectors[sector])
+	{
+		auto &sub = Subsectors[subsector];
+		for (unsigned i = 0; i < sub.numportals; i++)
+		{
+			auto &portal = Portals[sub.firstportal + i];
+			FPVSFlow flow = { this, row, onstack.Data(), 0, 0, false };
+
+			flow.Mark(portal.to);
+			onstack[subsector] = true;
+			flow.Flow(portal.to, portal.w, portal.w);
+			onstack[subsector] = false;
+
+			if (flow.overflow)
+			{
+				memset(row, 0xff, RowBytes);
+				memset(onstack.Data(), 0, onstack.Size());
+				return;
+			}
+		}
+	}
+}
+
+//==========================================================================
+//
+// Blockmap check
+//
+// The matrix says that a trace has to cross a one-sided line, but
+// P_CheckSight only finds that line if it is linked into every block the
+// trace can cross it in. Old node builders did not always guarantee this.
+//
+//==========================================================================
+
+static bool CheckBlockmapLines(FLevelLocals *Level)
+{
+	auto &bmap = Level->blockmap;
+	const double units = FBlockmap::MAPBLOCKUNITS;
+	const double shrink = 1. / 64;
+
+	for (auto &line : Level->lines)
+	{
+		if (line.backsector != nullptr) continue;
+
+		DVector2 v1 = line.v1->fPos() - DVector2(bmap.bmaporgx, bmap.bmaporgy);
+		DVector2 v2 = line.v2->fPos() - DVector2(bmap.bmaporgx, bmap.bmaporgy);
+		DVector2 d = v2 - v1;
+		int x1 = int(floor(min(v1.X, v2.X) / units)), x2 = int(floor(max(v1.X, v2.X) / units));
+		int y1 = int(floor(min(v1.Y, v2.Y) / units)), y2 = int(floor(max(v1.Y, v2.Y) / units));
+		int lineindex = line.Index();
+
+		for (int y = y1; y <= y2; y++)
+		{
+			for (int x = x1; x <= x2; x++)
+			{
+				// does the line pass through the inside of this block?
+				double bx1 = x * units + shrink, bx2 = (x + 1) * units - shrink;
+				double by1 = y * units + shrink, by2 = (y + 1) * units - shrink;
+				double c[4] = {
+					Cross(DVector2(bx1, by1) - v1, d), Cross(DVector2(bx2, by1) - v1, d),
+					Cross(DVector2(bx1, by2) - v1, d), Cross(DVector2(bx2, by2) - v1, d) };
+				if ((c[0] > 0 && c[1] > 0 && c[2] > 0 && c[3] > 0) || (c[0] < 0 && c[1] < 0 && c[2] < 0 && c[3] < 0))
+					continue;
+				if (max(v1.X, v2.X) < bx1 || min(v1.X, v2.X) > bx2 || max(v1.Y, v2.Y) < by1 || min(v1.Y, v2.Y) > by2)
+					continue;
+
+				if (!bmap.isValidBlock(x, y)) return false;
+				int *list = bmap.GetLines(x, y);
+				while (*list != -1 && *list != lineindex) list++;
+				if (*list == -1) return false;
+			}
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Caching, next to the node cache
+//
+//==========================================================================
+
+static void FillCacheHeader(FLevelLocals *Level, MapData *map, uint32_t *header)
+{
+	memcpy(header, "SPVS", 4);
+	header[1] = LittleLong(PVS_VERSION);
+	header[2] = LittleLong(Level->sectors.Size());
+	header[3] = LittleLong(Level->subsectors.Size());
+	header[4] = LittleLong(Level->segs.Size());
+	map->GetChecksum((uint8_t*)&header[5]);
+}
+
+static bool LoadCachedPVS(FLevelLocals *Level, MapData *map, TArray<uint8_t> &matrix)
+{
+	uint32_t header[9], cached[9];
+	FileReader fr;
+
+	if (!fr.OpenFile(CreateCacheName(map, false, ".gzs"))) return false;
+	if (fr.Read(cached, sizeof(cached)) != sizeof(cached)) return false;
+	FillCacheHeader(Level, map, header);
+	if (memcmp(header, cached, sizeof(header))) return false;
+
+	auto compressed = fr.Read();
+	uLongf outlen = matrix.Size();
+	return uncompress(matrix.Data(), &outlen, compressed.Data(), compressed.Size()) == Z_OK && outlen == matrix.Size();
+}
+
+static void CreateCachedPVS(FLevelLocals *Level, MapData *map, const TArray<uint8_t> &matrix)
+{
+	uint32_t header[9];
+	FillCacheHeader(Level, map, header);
+
+	uLongf outlen = compressBound(matrix.Size());
+	TArray<Bytef> compressed(outlen, true);
+	if (compress(compressed.Data(), &outlen, matrix.Data(), matrix.Size()) != Z_OK) return;
+
+	FString path = CreateCacheName(map, true, ".gzs");
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw != nullptr)
+	{
+		if (fw->Write(header, sizeof(header)) != sizeof(header) || fw->Write(compressed.Data(), outlen) != outlen)
+		{
+			Printf("Error saving sight data to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open sight data file %s for writing\n", path.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// MapLoader::BuildSightPVS
+//
+//==========================================================================
+
+static ctpl::thread_pool PVSPool;
+
+void MapLoader::BuildSightPVS(MapData *map)
+{
+	Level->sightpvs.Reset();
+
+	// Linked portals let traces leave the map's plane and polyobjects move
+	// their walls around, neither can be described by a static matrix.
+	if (!p_sightpvs || Level->maptype == MAPTYPE_BUILD || Level->Displacements.size > 1 || Level->Polyobjects.Size() > 0)
+		return;
+	if (Level->sectors.Size() < 2 || Level->sectors.Size() > PVS_MAXSECTORS)
+		return;
+	if (!CheckBlockmapLines(Level))
+	{
+		DPrintf(DMSG_NOTIFY, "Blockmap is missing lines, not using sight PVS\n");
+		return;
+	}
+
+	FSightPVSBuilder builder;
+	if (!builder.Setup(Level))
+	{
+		DPrintf(DMSG_NOTIFY, "Nodes cannot be used for the sight PVS\n");
+		return;
+	}
+
+	TArray<uint8_t> matrix(builder.RowBytes * builder.NumSectors, true);
+	if (!LoadCachedPVS(Level, map, matrix))
+	{
+		uint64_t startTime = I_msTime();
+
+		builder.Visible.Resize(matrix.Size());
+		memset(builder.Visible.Data(), 0, builder.Visible.Size());
+
+		int numthreads = max(1, (int)std::thread::hardware_concurrency());
+		if (PVSPool.size() != numthreads)
+		{
+			PVSPool.resize(numthreads);
+		}
+		TArray<TArray<uint8_t>> onstack(numthreads, true);
+		for (auto &stack : onstack)
+		{
+			stack.Resize(builder.Subsectors.Size());
+			memset(stack.Data(), 0, stack.Size());
+		}
+
+		std::vector<std::future<void>> jobs;
+		std::atomic<int> nextsector = { 0 };
+		for (int i = 0; i < numthreads; i++)
+		{
+			jobs.push_back(PVSPool.push([&](int threadid)
+			{
+				int sector;
+				while ((sector = nextsector++) < builder.NumSectors)
+				{
+					builder.BuildSector(sector, onstack[threadid]);
+				}
+			}));
+		}
+		for (auto &job : jobs)
+		{
+			job.wait();
+		}
+
+		// Store it inverted, like REJECT.
+		for (unsigned i = 0; i < matrix.Size(); i++)
+		{
+			matrix[i] = ~builder.Visible[i];
+		}
+
+		uint64_t buildtime = I_msTime() - startTime;
+		DPrintf(DMSG_NOTIFY, "Sight PVS generation took %.3f sec\n", buildtime * 0.001);
+		if (gl_cachenodes && buildtime / 1000.f >= gl_cachetime)
+		{
+			CreateCachedPVS(Level, map, matrix);
+		}
+	}
+	Level->sightpvs = std::move(matrix);
+}
@@ -33,6 +33,9 @@
 **
 */
 
+#include <atomic>
+#include <thread>
+
 #include "doomstat.h"
 #include "p_setup.h"
 #include "p_lnspec.h"
@@ -52,6 +55,7 @@
 #include "xlat/xlat.h"
 #include "maploader.h"
 #include "texturemanager.h"
+#include "ctpl.h"
 
 //===========================================================================
 //
@@ -386,6 +390,504 @@ FString GetUDMFString(FLevelLocals *Level, int type, int index, FName key)
 	return "";
 }
 
+//===========================================================================
+//
+// Parallel TEXTMAP scanning
+//
+// Large maps get split into chunks at the end of top level blocks, which
+// worker threads tokenize on their own. For every key they record what
+// ParseKey would have left in the scanner, so that the parser can
+// afterwards process the blocks in their original order without touching
+// the text again. Workers do not create names or print anything; anything
+// that would have required that is stored and done while replaying.
+// FScanner can't be used by the workers because it is full of FStrings,
+// which share a non-atomic reference counter for empty strings, so they
+// use FUDMFLexer and put strings into one buffer per chunk.
+//
+//===========================================================================
+
+enum
+{
+	// Smaller maps are scanned faster than the work can be handed out.
+	MinParallelTextMap = 1 << 20,
+	MinTextMapChunk = 1 << 18,
+};
+
+enum EUDMFBlock
+{
+	UB_Unknown,
+	UB_Thing,
+	UB_Linedef,
+	UB_Sidedef,
+	UB_Sector,
+	UB_Vertex,
+};
+
+struct FUDMFScannedKey
+{
+	FName Key;
+	int TokenType;
+	int Number;
+	double Float;
+	int Line;
+	int SignLine;		// line of a sign without a number after it, 0 if none
+	unsigned KeyString;	// only for keys that are not in the name table yet
+	unsigned String;	// only for string constants
+};
+
+struct FUDMFScannedBlock
+{
+	EUDMFBlock Type;
+	unsigned FirstKey;
+	unsigned NumKeys;
+};
+
+struct FUDMFChunk
+{
+	const char *Start;
+	size_t Size;
+	int Line;
+	bool Failed;
+	TArray<FUDMFScannedBlock> Blocks;
+	TArray<FUDMFScannedKey> Keys;
+	TArray<char> Strings;
+};
+
+static ctpl::thread_pool UDMFPool;
+
+static unsigned AddString(TArray<char> &strings, const char *str, size_t len)
+{
+	unsigned ofs = strings.Reserve(len + 1);
+	memcpy(&strings[ofs], str, len);
+	strings[ofs + len] = 0;
+	return ofs;
+}
+
+static EUDMFBlock GetBlockType(const char *name)
+{
+	if (!stricmp(name, "thing")) return UB_Thing;
+	if (!stricmp(name, "linedef")) return UB_Linedef;
+	if (!stricmp(name, "sidedef")) return UB_Sidedef;
+	if (!stricmp(name, "sector")) return UB_Sector;
+	if (!stricmp(name, "vertex")) return UB_Vertex;
+	return UB_Unknown;
+}
+
+//===========================================================================
+//
+// Splits the text after the closing brace of known blocks only. After
+// skipping an unknown block the scanner is left in a state that depends
+// on what comes next, so such places are not safe to cut. Anything this
+// gets wrong makes a worker fail, which sends the map to the serial parser.
+//
+//===========================================================================
+
+static void SplitTextMap(const char *start, const char *end, int line, size_t chunksize, TArray<FUDMFChunk> &chunks)
+{
+	const char *chunkstart = start;
+	int chunkline = line;
+	const char *word = nullptr;
+	size_t wordlen = 0;
+	bool known = false;
+	int depth = 0;
+
+	for (const char *p = start; p < end; p++)
+	{
+		char c = *p;
+		if (c == '\n')
+		{
+			line++;
+		}
+		else if (c == '/' && p + 1 < end && p[1] == '/')
+		{
+			while (p + 1 < end && p[1] != '\n') p++;
+		}
+		else if (c == '/' && p + 1 < end && p[1] == '*')
+		{
+			for (p += 2; p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/'); p++)
+			{
+				if (*p == '\n') line++;
+			}
+			if (p < end) p++;
+		}
+		else if (c == '"' || c == '\'')
+		{
+			for (p++; p < end && *p != c; p++)
+			{
+				if (c == '"' && *p == '\\' && p + 1 < end) p++;
+				if (*p == '\n') line++;
+			}
+			word = nullptr;
+		}
+		else if (isalnum((uint8_t)c) || c == '_')
+		{
+			const char *wordstart = p;
+			while (p + 1 < end && (isalnum((uint8_t)p[1]) || p[1] == '_' || p[1] == '.')) p++;
+			if (depth == 0)
+			{
+				word = wordstart;
+				wordlen = p + 1 - wordstart;
+			}
+		}
+		else if (c == '{')
+		{
+			if (depth++ == 0)
+			{
+				char name[16];
+				known = word != nullptr && wordlen < sizeof(name);
+				if (known)
+				{
+					memcpy(name, word, wordlen);
+					name[wordlen] = 0;
+					known = GetBlockType(name) != UB_Unknown;
+				}
+			}
+		}
+		else if (c == '}')
+		{
+			if (depth > 0 && --depth == 0 && known && size_t(p + 1 - chunkstart) >= chunksize)
+			{
+				chunks.Push({ chunkstart, size_t(p + 1 - chunkstart), chunkline, false });
+				chunkstart = p + 1;
+				chunkline = line;
+			}
+			word = nullptr;
+		}
+		else if (c > ' ')
+		{
+			word = nullptr;
+		}
+	}
+	if (chunkstart < end)
+	{
+		chunks.Push({ chunkstart, size_t(end - chunkstart), chunkline, false });
+	}
+}
+
+//===========================================================================
+//
+// A tokenizer for the worker threads. It only knows the forms of tokens
+// that UDMF maps normally consist of and gives up on anything else, e.g.
+// unknown top level blocks, hex numbers or escaped quotes. The map then
+// goes through the serial parser. For everything it accepts, it produces
+// the same tokens, values and line numbers as FScanner in C mode.
+//
+//===========================================================================
+
+struct FUDMFLexer
+{
+	struct Error {};
+
+	const char *Pos;
+	const char *End;
+	int Line;
+
+	int TokenType = 0;
+	int Number = 0;
+	double Float = 0;
+	const char *Token = nullptr;	// identifier or contents of a string constant
+	size_t TokenLen = 0;
+
+	static bool IsNameStart(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	}
+
+	static bool IsNameChar(char c)
+	{
+		return IsNameStart(c) || (c >= '0' && c <= '9');
+	}
+
+	static bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	// Returns false at the end of the text.
+	bool SkipWhitespace()
+	{
+		while (Pos < End)
+		{
+			char c = *Pos;
+			if (c == '\n')
+			{
+				Line++;
+				Pos++;
+			}
+			else if ((uint8_t)c <= ' ')
+			{
+				Pos++;
+			}
+			else if (c == '/' && Pos + 1 < End && Pos[1] == '/')
+			{
+				while (Pos < End && *Pos != '\n') Pos++;
+			}
+			else if (c == '/' && Pos + 1 < End && Pos[1] == '*')
+			{
+				for (Pos += 2; Pos < End && !(Pos[0] == '*' && Pos + 1 < End && Pos[1] == '/'); Pos++)
+				{
+					if (*Pos == '\n') Line++;
+				}
+				Pos = Pos < End ? Pos + 2 : End;
+			}
+			else
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Same as FScanner::GetString for block names and keys.
+	bool GetName()
+	{
+		if (!SkipWhitespace()) return false;
+		if (!IsNameStart(*Pos)) throw Error();
+
+		const char *p = Pos + 1;
+		while (p < End && IsNameChar(*p)) p++;
+		// FScanner only ends the string at whitespace and punctuation.
+		if (p < End && (uint8_t)*p > ' ' && !strchr("{}|=/`~!@#$%^&*()[]\\?-+;:<>,.\"", *p)) throw Error();
+
+		Token = Pos;
+		TokenLen = p - Pos;
+		Pos = p;
+		return true;
+	}
+
+	void MustGetAnyToken()
+	{
+		if (!SkipWhitespace()) throw Error();
+
+		const char *p = Pos;
+		char c = *p;
+		if (IsNameStart(c))
+		{
+			while (++p < End && IsNameChar(*p)) {}
+			// Any other identifier could be one of FScanner's keywords.
+			if (p - Pos == 4 && !strnicmp(Pos, "true", 4)) TokenType = TK_True;
+			else if (p - Pos == 5 && !strnicmp(Pos, "false", 5)) TokenType = TK_False;
+			else throw Error();
+		}
+		else if (IsDigit(c) || (c == '.' && p + 1 < End && IsDigit(p[1])))
+		{
+			bool isfloat = false;
+			while (p < End && IsDigit(*p)) p++;
+			if (p < End && *p == '.')
+			{
+				isfloat = true;
+				for (p++; p < End && IsDigit(*p); p++) {}
+			}
+			if (p < End && (*p == 'e' || *p == 'E'))
+			{
+				const char *e = p + 1;
+				if (e < End && (*e == '+' || *e == '-')) e++;
+				if (e == End || !IsDigit(*e)) throw Error();
+				while (e < End && IsDigit(*e)) e++;
+				p = e;
+				isfloat = true;
+			}
+			// Suffixes, hex and anything else FScanner might split up differently
+			if (p < End && (IsNameChar(*p) || *p == '.')) throw Error();
+
+			char number[64];
+			size_t len = p - Pos;
+			if (len >= sizeof(number)) throw Error();
+			memcpy(number, Pos, len);
+			number[len] = 0;
+			if (isfloat)
+			{
+				TokenType = TK_FloatConst;
+				Float = strtod(number, nullptr);
+			}
+			else
+			{
+				// A leading 0 makes it octal for FScanner. Long numbers would overflow.
+				if ((number[0] == '0' && len > 1) || len > 18) throw Error();
+				TokenType = TK_IntConst;
+				Number = (int)strtoll(number, nullptr, 10);
+				Float = Number;
+			}
+		}
+		else if (c == '"')
+		{
+			for (p++; p < End && *p != '"'; p++)
+			{
+				// FScanner's rule for escaped quotes is ambiguous in places.
+				if (*p == '\\' && p + 1 < End && p[1] == '"') throw Error();
+				if (*p == '\n') Line++;
+			}
+			if (p == End) throw Error();
+			TokenType = TK_StringConst;
+			Token = Pos + 1;
+			TokenLen = p - Token;
+			p++;
+		}
+		else if (c == '{' || c == '}' || c == '=' || c == ';' || c == '+' || c == '-')
+		{
+			p++;
+			// ==, ++, +=, --, -= and -> are tokens of their own.
+			if (p < End && ((c == '=' && *p == '=') || (c == '+' && (*p == '+' || *p == '=')) ||
+				(c == '-' && (*p == '-' || *p == '=' || *p == '>'))))
+			{
+				throw Error();
+			}
+			TokenType = c;
+		}
+		else
+		{
+			throw Error();
+		}
+		Pos = p;
+	}
+
+	void MustGetToken(int token)
+	{
+		MustGetAnyToken();
+		if (TokenType != token) throw Error();
+	}
+
+	bool CheckToken(char token)
+	{
+		if (SkipWhitespace() && *Pos == token)
+		{
+			Pos++;
+			TokenType = token;
+			return true;
+		}
+		return false;
+	}
+};
+
+//===========================================================================
+//
+// Same as UDMFParserBase::ParseKey, but stores the result
+//
+//===========================================================================
+
+static void ScanKey(FUDMFLexer &sc, FUDMFScannedKey &key, TArray<char> &strings)
+{
+	if (!sc.GetName()) throw FUDMFLexer::Error();
+	key.Key = FName(sc.Token, sc.TokenLen, true);
+	if (key.Key == NAME_None) key.KeyString = AddString(strings, sc.Token, sc.TokenLen);
+	key.SignLine = 0;
+	sc.MustGetToken('=');
+
+	sc.Number = 0;
+	sc.Float = 0;
+	sc.MustGetAnyToken();
+
+	if (sc.TokenType == '+' || sc.TokenType == '-')
+	{
+		bool neg = (sc.TokenType == '-');
+		sc.MustGetAnyToken();
+		if (sc.TokenType != TK_IntConst && sc.TokenType != TK_FloatConst)
+		{
+			key.SignLine = sc.Line;
+		}
+		if (neg)
+		{
+			sc.Number = -sc.Number;
+			sc.Float = -sc.Float;
+		}
+	}
+	if (sc.TokenType == TK_StringConst)
+	{
+		key.String = AddString(strings, sc.Token, sc.TokenLen);
+		// Resolve the escape sequences the same way FScanner::GetToken does.
+		strbin(&strings[key.String]);
+	}
+	key.TokenType = sc.TokenType;
+	key.Number = sc.Number;
+	key.Float = sc.Float;
+	sc.MustGetToken(';');
+	key.Line = sc.Line;
+}
+
+static void ScanChunk(FUDMFChunk &chunk)
+{
+	FUDMFLexer sc = { chunk.Start, chunk.Start + chunk.Size, chunk.Line };
+	try
+	{
+		while (sc.GetName())
+		{
+			// The serial parser deals with unknown blocks and keys.
+			char name[16];
+			if (sc.TokenLen >= sizeof(name)) throw FUDMFLexer::Error();
+			memcpy(name, sc.Token, sc.TokenLen);
+			name[sc.TokenLen] = 0;
+
+			FUDMFScannedBlock &block = chunk.Blocks[chunk.Blocks.Reserve(1)];
+			block.Type = GetBlockType(name);
+			if (block.Type == UB_Unknown) throw FUDMFLexer::Error();
+			block.FirstKey = chunk.Keys.Size();
+			sc.MustGetToken('{');
+			while (!sc.CheckToken('}'))
+			{
+				ScanKey(sc, chunk.Keys[chunk.Keys.Reserve(1)], chunk.Strings);
+			}
+			block.NumKeys = chunk.Keys.Size() - block.FirstKey;
+		}
+	}
+	catch (...)
+	{
+		chunk.Failed = true;
+	}
+}
+
+//===========================================================================
+//
+// Returns false if the map should be parsed serially instead.
+//
+//===========================================================================
+
+static bool ScanTextMap(const char *start, const char *end, int line, TArray<FUDMFChunk> &chunks)
+{
+	int numthreads = max(1, (int)std::thread::hardware_concurrency());
+	size_t size = end - start;
+	if (numthreads < 2 || size < MinParallelTextMap)
+	{
+		return false;
+	}
+
+	SplitTextMap(start, end, line, max<size_t>(MinTextMapChunk, size / (numthreads * 4)), chunks);
+	if (chunks.Size() < 2)
+	{
+		return false;
+	}
+
+	if (UDMFPool.size() != numthreads)
+	{
+		UDMFPool.resize(numthreads);
+	}
+	std::vector<std::future<void>> jobs;
+	std::atomic<unsigned> nextchunk = { 0 };
+	for (int i = 0; i < numthreads; i++)
+	{
+		jobs.push_back(UDMFPool.push([&](int threadid)
+		{
+			unsigned chunk;
+			while ((chunk = nextchunk++) < chunks.Size())
+			{
+				ScanChunk(chunks[chunk]);
+			}
+		}));
+	}
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+
+	for (auto &chunk : chunks)
+	{
+		if (chunk.Failed)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 //===========================================================================
 //
 // UDMF parser
@@ -418,6 +920,12 @@ class UDMFParser : public UDMFParserBase
 	FDynamicColormap	*fogMap = nullptr, *normMap = nullptr;
 	FMissingTextureTracker &missingTex;
 
+	// Keys of the current block when processing the output of ScanTextMap
+	bool Replaying = false;
+	const FUDMFScannedKey *ReplayKey = nullptr;
+	const FUDMFScannedKey *ReplayEnd = nullptr;
+	const char *ReplayStrings = nullptr;
+
 public:
 	UDMFParser(MapLoader *ld, FMissingTextureTracker &missing)
 		: loader(ld), Level(ld->Level), missingTex(missing)
@@ -425,6 +933,44 @@ public:
 		loader->linemap.Clear();
 	}
 
+	//===========================================================================
+	//
+	// Block and key access that works for both the scanner and the
+	// recorded keys.
+	//
+	//===========================================================================
+
+	void BeginBlock()
+	{
+		if (!Replaying) sc.MustGetToken('{');
+	}
+
+	bool EndOfBlock()
+	{
+		return Replaying ? ReplayKey == ReplayEnd : sc.CheckToken('}');
+	}
+
+	FName ParseKey()
+	{
+		if (!Replaying) return UDMFParserBase::ParseKey();
+
+		const FUDMFScannedKey &key = *ReplayKey++;
+		if (key.SignLine > 0)
+		{
+			sc.Line = key.SignLine;
+			sc.ScriptMessage("Numeric constant expected");
+		}
+		sc.Line = key.Line;
+		sc.TokenType = key.TokenType;
+		sc.Number = key.Number;
+		sc.Float = key.Float;
+		if (key.TokenType == TK_StringConst)
+		{
+			parsedString = ReplayStrings + key.String;
+		}
+		return key.Key != NAME_None ? key.Key : FName(ReplayStrings + key.KeyString);
+	}
+
   void ReadUserKey(FUDMFKey &ukey) {
 		switch (sc.TokenType)
 		{
@@ -480,8 +1026,8 @@ public:
 		th->Alpha = -1;
 		th->Health = 1;
 		th->FloatbobPhase = -1;
-		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		BeginBlock();
+		while (!EndOfBlock())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -832,8 +1378,8 @@ public:
 		if (Level->flags2 & LEVEL2_WRAPMIDTEX) ld->flags |= ML_WRAP_MIDTEX;
 		if (Level->flags2 & LEVEL2_CHECKSWITCHRANGE) ld->flags |= ML_CHECKSWITCHRANGE;
 
-		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		BeginBlock();
+		while (!EndOfBlock())
 		{
 			FName key = ParseKey();
 
@@ -1223,8 +1769,8 @@ public:
 		sd->SetTextureYScale(1.);
 		sd->UDMFIndex = index;
 
-		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		BeginBlock();
+		while (!EndOfBlock())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -1559,8 +2105,8 @@ public:
 		sec->friction = ORIG_FRICTION;
 		sec->movefactor = ORIG_FRICTION_FACTOR;
 
-		sc.MustGetToken('{');
-		while (!sc.CheckToken('}'))
+		BeginBlock();
+		while (!EndOfBlock())
 		{
 			FName key = ParseKey();
 			switch(key.GetIndex())
@@ -2105,9 +2651,9 @@ public:
 		vt->set(0, 0);
 		vd->zCeiling = vd->zFloor = vd->flags = 0;
 
-		sc.MustGetToken('{');
+		BeginBlock();
 		double x = 0, y = 0;
-		while (!sc.CheckToken('}'))
+		while (!EndOfBlock())
 		{
 			FName key = ParseKey();
 			switch (key.GetIndex())
@@ -2231,6 +2777,71 @@ public:
 		}
 	}
 
+	//===========================================================================
+	//
+	// Processes one top level block
+	//
+	//===========================================================================
+
+	void ParseBlock(EUDMFBlock type)
+	{
+		switch (type)
+		{
+		case UB_Thing:
+		{
+			FMapThing th;
+			unsigned userdatastart = loader->MapThingsUserData.Size();
+			ParseThing(&th);
+			loader->MapThingsConverted.Push(th);
+			if (userdatastart < loader->MapThingsUserData.Size())
+			{ // User data added
+				loader->MapThingsUserDataIndex[loader->MapThingsConverted.Size()-1] = userdatastart;
+				// Mark end of the user data for this map thing
+				FUDMFKey ukey;
+				ukey.Key = NAME_None;
+				ukey = 0;
+				loader->MapThingsUserData.Push(ukey);
+			}
+			break;
+		}
+		case UB_Linedef:
+		{
+			line_t li;
+			ParseLinedef(&li, ParsedLines.Size());
+			ParsedLines.Push(li);
+			break;
+		}
+		case UB_Sidedef:
+		{
+			side_t si;
+			intmapsidedef_t st;
+			ParseSidedef(&si, &st, ParsedSides.Size());
+			ParsedSides.Push(si);
+			ParsedSideTextures.Push(st);
+			break;
+		}
+		case UB_Sector:
+		{
+			sector_t sec;
+			memset(&sec, 0, sizeof(sector_t));
+			ParseSector(&sec, ParsedSectors.Size());
+			ParsedSectors.Push(sec);
+			break;
+		}
+		case UB_Vertex:
+		{
+			vertex_t vt;
+			vertexdata_t vd;
+			ParseVertex(&vt, &vd);
+			ParsedVertices.Push(vt);
+			loader->vertexdatas.Push(vd);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
 	//===========================================================================
 	//
 	// Main parsing function
@@ -2243,8 +2854,16 @@ public:
 		isExtended = false;
 		floordrop = false;
 
-		sc.OpenMem(fileSystem.GetFileFullName(map->lumpnum), map->Read(ML_TEXTMAP));
+		auto textmap = map->Read(ML_TEXTMAP);
+		sc.OpenMem(fileSystem.GetFileFullName(map->lumpnum), textmap);
 		sc.SetCMode(true);
+
+		// The scanner drops a UTF-8 byte order mark from its copy of the text.
+		auto start = sc.SavePos();
+		size_t textsize = textmap.Size();
+		if (textsize > 3 && textmap[0] == 0xEF && textmap[1] == 0xBB && textmap[2] == 0xBF) textsize -= 3;
+		const char *textend = start.SavedScriptPtr + textsize;
+
 		if (sc.CheckString("namespace"))
 		{
 			sc.MustGetStringName("=");
@@ -2312,62 +2931,43 @@ public:
 				}
 			}
 			sc.MustGetStringName(";");
+			start = sc.SavePos();
 		}
 		else
 		{
 			Printf("Map does not define a namespace.\n");
 		}
 
-		while (sc.GetString())
+		TArray<FUDMFChunk> chunks;
+		if (start.SavedScriptPtr != nullptr && ScanTextMap(start.SavedScriptPtr, textend, start.SavedScriptLine, chunks))
 		{
-			if (sc.Compare("thing"))
+			sc.RestorePos(start);
+			Replaying = true;
+			for (auto &chunk : chunks)
 			{
-				FMapThing th;
-				unsigned userdatastart = loader->MapThingsUserData.Size();
-				ParseThing(&th);
-				loader->MapThingsConverted.Push(th);
-				if (userdatastart < loader->MapThingsUserData.Size())
-				{ // User data added
-					loader->MapThingsUserDataIndex[loader->MapThingsConverted.Size()-1] = userdatastart;
-					// Mark end of the user data for this map thing
-					FUDMFKey ukey;
-					ukey.Key = NAME_None;
-					ukey = 0;
-					loader->MapThingsUserData.Push(ukey);
+				for (auto &block : chunk.Blocks)
+				{
+					ReplayKey = chunk.Keys.Data() + block.FirstKey;
+					ReplayEnd = ReplayKey + block.NumKeys;
+					ReplayStrings = chunk.Strings.Data();
+					ParseBlock(block.Type);
 				}
 			}
-			else if (sc.Compare("linedef"))
-			{
-				line_t li;
-				ParseLinedef(&li, ParsedLines.Size());
-				ParsedLines.Push(li);
-			}
-			else if (sc.Compare("sidedef"))
-			{
-				side_t si;
-				intmapsidedef_t st;
-				ParseSidedef(&si, &st, ParsedSides.Size());
-				ParsedSides.Push(si);
-				ParsedSideTextures.Push(st);
-			}
-			else if (sc.Compare("sector"))
-			{
-				sector_t sec;
-				memset(&sec, 0, sizeof(sector_t));
-				ParseSector(&sec, ParsedSectors.Size());
-				ParsedSectors.Push(sec);
-			}
-			else if (sc.Compare("vertex"))
-			{
-				vertex_t vt;
-				vertexdata_t vd;
-				ParseVertex(&vt, &vd);
-				ParsedVertices.Push(vt);
-				loader->vertexdatas.Push(vd);
-			}
-			else
+			Replaying = false;
+		}
+		else
+		{
+			while (sc.GetString())
 			{
-				Skip();
+				EUDMFBlock type = GetBlockType(sc.String);
+				if (type != UB_Unknown)
+				{
+					ParseBlock(type);
+				}
+				else
+				{
+					Skip();
+				}
 			}
 		}
 
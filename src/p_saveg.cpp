@@ -64,6 +64,7 @@
 #include "model.h"
 
 EXTERN_CVAR(Bool, save_formatted)
+EXTERN_CVAR(Bool, save_json)
 
 //==========================================================================
 //
@@ -1073,11 +1074,12 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 
 //==========================================================================
 //
-// Archives the current level
+// Archives the current level. The savegame writer leaves the
+// snapshot uncompressed and deflates it on its own thread.
 //
 //==========================================================================
 
-void FLevelLocals::SnapshotLevel()
+void FLevelLocals::SnapshotLevel(bool compress)
 {
 	info->Snapshot.Clean();
 
@@ -1085,11 +1087,11 @@ void FLevelLocals::SnapshotLevel()
 	{
 		FDoomSerializer arc(this);
 
-		if (arc.OpenWriter(save_formatted))
+		if (arc.OpenWriter(save_formatted, !save_formatted && !save_json))
 		{
 			SaveVersion = SAVEVER;
 			Serialize(arc, false);
-			info->Snapshot = arc.GetCompressedOutput();
+			info->Snapshot = compress ? arc.GetCompressedOutput() : arc.GetStoredOutput();
 		}
 	}
 }
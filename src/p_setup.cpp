@@ -348,6 +348,8 @@ void FLevelLocals::ClearLevelData(bool fullgc)
 	subsectors.Clear();
 	gamesubsectors.Reset();
 	rejectmatrix.Clear();
+	sightpvs.Clear();
+	subsectorhulls.Clear();
 	Zones.Clear();
 	blockmap.Clear();
 	Polyobjects.Clear();
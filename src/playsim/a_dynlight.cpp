@@ -64,9 +64,12 @@
 #include "a_dynlight.h"
 #include "actorinlines.h"
 #include "memarena.h"
+#include "stats.h"
 
 static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
+static FMemArena LightNodeArena(sizeof(FLightNode) * 1000);
+static FLightNode *FreeLightNodes;
 static FRandom randLight;
 
 extern TArray<FLightDefaults *> StateLights;
@@ -249,6 +252,7 @@ void FDynamicLight::Tick()
 	if (!target)
 	{
 		// How did we get here? :?
+		UnlinkLight();
 		ReleaseLight();
 		return;
 	}
@@ -421,27 +425,66 @@ void FDynamicLight::UpdateLocation()
 // sectors this object appears in. This is called when creating a list of
 // nodes that will get linked in later. Returns a pointer to the new node.
 //
+// The lightlinks stat only covers this relinking. Which lights the renderer
+// applies to a surface is still decided by the per-side and per-section
+// lists built here; there is no separate clustered assignment.
+//
 //=============================================================================
 
+static struct FLightLinkStats
+{
+	cycle_t time;
+	int links;
+	int kept;
+	int added;
+	int removed;
+} LightLinkStats;
+
+void ResetLightLinkStats()
+{
+	LightLinkStats.time.Reset();
+	LightLinkStats.links = LightLinkStats.kept = LightLinkStats.added = LightLinkStats.removed = 0;
+}
+
+ADD_STAT(lightlinks)
+{
+	FString out;
+	out.Format("Light links: %04.2f ms, %d lights relinked, %d nodes kept, %d added, %d removed",
+		LightLinkStats.time.TimeMS(), LightLinkStats.links, LightLinkStats.kept, LightLinkStats.added, LightLinkStats.removed);
+	return out;
+}
+
 FLightNode * AddLightNode(FLightNode ** thread, void * linkto, FDynamicLight * light, FLightNode *& nextnode)
 {
 	FLightNode * node;
 
-	node = nextnode;
-	while (node)
-    {
-		if (node->targ==linkto)   // Already have a node for this sector?
+	// Already have a node for this target? While LinkLight runs, the light's
+	// old nodes are the only ones without a light source, so it is enough to
+	// look through the target's list, which is a lot shorter than the light's
+	// own for large lights.
+	for (node = *thread; node; node = node->nextLight)
+	{
+		if (node->lightsource == nullptr || node->lightsource == light)
 		{
-			node->lightsource = light; // Yes. Setting m_thing says 'keep it'.
+			node->lightsource = light; // Yes. Setting lightsource says 'keep it'.
+			LightLinkStats.kept++;
 			return(nextnode);
 		}
-		node = node->nextTarget;
-    }
+	}
 
 	// Couldn't find an existing node for this sector. Add one at the head
 	// of the list.
 	
-	node = new FLightNode;
+	if (FreeLightNodes != nullptr)
+	{
+		node = FreeLightNodes;
+		FreeLightNodes = node->nextTarget;
+	}
+	else
+	{
+		node = (FLightNode *)LightNodeArena.Alloc(sizeof(FLightNode));
+	}
+	LightLinkStats.added++;
 	
 	node->targ = linkto;
 	node->lightsource = light; 
@@ -484,7 +527,8 @@ static FLightNode * DeleteLightNode(FLightNode * node)
 		
 		// Return this node to the freelist
 		tn=node->nextTarget;
-		delete node;
+		node->nextTarget = FreeLightNodes;
+		FreeLightNodes = node;
 		return(tn);
 	}
 	return(nullptr);
@@ -676,6 +720,8 @@ void FDynamicLight::LinkLight()
 		node = node->nextTarget;
 	}
 
+	LightLinkStats.time.Clock();
+	LightLinkStats.links++;
 	if (radius>0)
 	{
 		// passing in radius*radius allows us to do a distance check without any calls to sqrt
@@ -696,6 +742,7 @@ void FDynamicLight::LinkLight()
 		if (node->lightsource == nullptr)
 		{
 			node = DeleteLightNode(node);
+			LightLinkStats.removed++;
 		}
 		else
 			node = node->nextTarget;
@@ -707,10 +754,12 @@ void FDynamicLight::LinkLight()
 		if (node->lightsource == nullptr)
 		{
 			node = DeleteLightNode(node);
+			LightLinkStats.removed++;
 		}
 		else
 			node = node->nextTarget;
 	}
+	LightLinkStats.time.Unclock();
 }
 
 
@@ -180,6 +180,8 @@ protected:
 };
 
 
+void ResetLightLinkStats();
+
 struct FLightNode
 {
 	FLightNode ** prevTarget;
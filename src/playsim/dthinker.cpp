@@ -47,13 +47,20 @@
 #include "d_main.h"
 
 static int ThinkCount;
-static cycle_t ThinkCycles;
+cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
 
 IMPLEMENT_CLASS(DThinker, false, false)
 
+// Number of worker threads for the parallel phase of RunThinkers. 0 runs everything on the game thread.
+CUSTOM_CVAR(Int, p_thinkthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > 64) self = 64;
+}
+
 struct ProfileInfo
 {
 	int numcalls = 0;
@@ -118,6 +125,7 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		dolights = false;
 	}
 	Level->flags3 &= ~LEVEL3_LIGHTCREATED;
+	if (dolights) ResetLightLinkStats();
 
 
 	auto recreateLights = [=]() {
@@ -141,6 +149,14 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 
 	if (!profilethinkers)
 	{
+		// Parallel phase: everything done here must only read the level and must
+		// produce results that are validated when used, so that the serial phase
+		// below plays out exactly as without it.
+		if (p_thinkthreads > 0)
+		{
+			P_PrepareSightChecks(Level, p_thinkthreads);
+		}
+
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
@@ -157,6 +173,8 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 			}
 		} while (count != 0);
 
+		P_ClearPreparedSight();
+
 		recreateLights();
 		if (dolights)
 		{
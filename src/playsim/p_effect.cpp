@@ -177,7 +177,7 @@ void P_InitParticles (FLevelLocals *Level)
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Level->Particles.Resize(NumParticles);
 	P_ClearParticles (Level);
@@ -210,13 +210,13 @@ void P_FindParticleSubsectors (FLevelLocals *Level)
 		Level->ParticlesInSubsec.Reserve (Level->subsectors.Size() - Level->ParticlesInSubsec.Size());
 	}
 
-	fillshort (&Level->ParticlesInSubsec[0], Level->subsectors.Size(), NO_PARTICLE);
+	memset (&Level->ParticlesInSubsec[0], 0xff, Level->subsectors.Size() * sizeof(uint32_t));
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+	for (uint32_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
 	{
 		 // Try to reuse the subsector from the last portal check, if still valid.
 		if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
@@ -265,7 +265,7 @@ void P_InitEffects ()
 
 void P_ThinkParticles (FLevelLocals *Level)
 {
-	int i = Level->ActiveParticles;
+	uint32_t i = Level->ActiveParticles;
 	particle_t *particle = nullptr, *prev = nullptr;
 	while (i != NO_PARTICLE)
 	{
@@ -294,7 +294,7 @@ void P_ThinkParticles (FLevelLocals *Level)
 				next->tprev = particle->tprev;
 			}
 			particle->tnext = Level->InactiveParticles;
-			Level->InactiveParticles = (int)(particle - Level->Particles.Data());
+			Level->InactiveParticles = uint32_t(particle - Level->Particles.Data());
 			continue;
 		}
 
@@ -311,7 +311,11 @@ void P_ThinkParticles (FLevelLocals *Level)
 			particle->RollVel += particle->RollAcc;
 		}
 		
-		particle->subsector = Level->PointInRenderSubsector(particle->Pos);
+		// Most particles move only a few units per tic, so the BSP rarely needs to be walked.
+		if (particle->subsector == nullptr || !Level->subsectorhulls.Contains(particle->subsector->Index(), particle->Pos.XY()))
+		{
+			particle->subsector = Level->PointInRenderSubsector(particle->Pos);
+		}
 		sector_t *s = particle->subsector->sector;
 		// Handle crossing a sector portal.
 		if (!s->PortalBlocksMovement(sector_t::ceiling))
@@ -279,6 +279,19 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_PrepareSightChecks (FLevelLocals *Level, int numthreads);
+void	P_ClearPreparedSight ();
+
+struct FSightBatch
+{
+	FLevelLocals *Level = nullptr;
+	FLevelLocals *PrevLevel;
+	unsigned FirstTrace;
+	unsigned FirstLine;
+};
+void	P_PrepareSightBatch (FSightBatch &batch, FLevelLocals *Level, const TArray<AActor *> &lookers, AActor *target, int numthreads);
+void	P_ReleaseSightBatch (FSightBatch &batch);
+
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
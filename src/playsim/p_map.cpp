@@ -96,6 +96,7 @@
 CVAR(Bool, cl_bloodsplats, true, CVAR_ARCHIVE)
 CVAR(Int, sv_smartaim, 0, CVAR_ARCHIVE | CVAR_SERVERINFO)
 CVAR(Bool, cl_doautoaim, false, CVAR_ARCHIVE)
+EXTERN_CVAR(Int, p_thinkthreads)
 
 static void CheckForPushSpecial(line_t *line, int side, AActor *mobj, DVector2 * posforwindowcheck = NULL);
 static void SpawnShootDecal(AActor *t1, AActor *defaults, const FTraceResults &trace);
@@ -1789,7 +1790,7 @@ bool P_CheckPosition(AActor *thing, const DVector2 &pos, FCheckPosition &tm, boo
 	tm.pos.Y = pos.Y;
 	tm.pos.Z = thing->Z();
 
-	newsec = tm.sector = thing->Level->PointInSector(pos);
+	newsec = tm.sector = thing->Level->PointInSector(pos, thing->subsector);
 	tm.ceilingline = thing->BlockingLine = NULL;
 
 	// Retrieve the base floor / ceiling from the target location.
@@ -6083,6 +6084,11 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 		targets.Push(thing);
 	}
 
+	// The sight checks below find their blockmap walks already recorded
+	// when there are enough targets to make doing that in parallel worth it.
+	FSightBatch sightbatch;
+	P_PrepareSightBatch(sightbatch, bombspot->Level, targets, bombspot, p_thinkthreads);
+
 	for (AActor *thing : targets)
 	{
 		// Barrels always use the original code, since this makes
@@ -6167,6 +6173,7 @@ int P_RadiusAttack(AActor *bombspot, AActor *bombsource, int bombdamage, int bom
 			}
 		}
 	}
+	P_ReleaseSightBatch(sightbatch);
 	return count;
 }
 
@@ -453,11 +453,22 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 		}
 	}
 
+	// Most moves end in the subsector the actor was already in. If it is still
+	// safely inside that one, walking the BSP will find it again, so this can be
+	// skipped. The gameplay nodes are only the same if they were not kept separately.
+	bool samesubsector = false;
+	if (!spawningmapthing && subsector != nullptr)
+	{
+		// for travelling actors this may still point into the previous level.
+		size_t index = subsector - Level->subsectors.Data();
+		samesubsector = index < Level->subsectors.Size() && Level->subsectorhulls.Contains(unsigned(index), Pos().XY());
+	}
+
 	if (sector == NULL)
 	{
 		if (!spawning)
 		{
-			sector = Level->PointInSector(Pos());
+			sector = samesubsector && Level->gamenodes.Size() == 0 ? subsector->sector : Level->PointInSector(Pos());
 		}
 		else
 		{
@@ -466,7 +477,10 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 	}
 
 	Sector = sector;
-	subsector = Level->PointInRenderSubsector(Pos());	// this is from the rendering nodes, not the gameplay nodes!
+	if (!samesubsector)
+	{
+		subsector = Level->PointInRenderSubsector(Pos());	// this is from the rendering nodes, not the gameplay nodes!
+	}
 	section = subsector->section;
 
 	if (!(flags & MF_NOSECTOR))
@@ -931,6 +945,50 @@ void FBlockThingsIterator::ClearHash()
 	memset(Buckets, -1, sizeof(Buckets));
 	NumFixedHash = 0;
 	DynHash.Clear();
+	DynBuckets.Clear();
+}
+
+//===========================================================================
+//
+// FBlockThingsIterator :: GetBucket
+//
+//===========================================================================
+
+int *FBlockThingsIterator::GetBucket(AActor *me)
+{
+	if (DynBuckets.Size() == 0)
+	{
+		return &Buckets[((size_t)me >> 3) % countof(Buckets)];
+	}
+	size_t hash = (size_t)me;
+	hash = (hash >> 4) ^ (hash >> 13);
+	return &DynBuckets[hash & (DynBuckets.Size() - 1)];
+}
+
+//===========================================================================
+//
+// FBlockThingsIterator :: GrowHash
+//
+// Keeps the average chain length below 2. This only changes where the
+// entries are found, not the order in which actors are returned.
+//
+//===========================================================================
+
+void FBlockThingsIterator::GrowHash()
+{
+	int numentries = NumFixedHash + DynHash.Size();
+	unsigned numbuckets = DynBuckets.Size() == 0 ? countof(Buckets) : DynBuckets.Size();
+	if (numentries <= int(numbuckets * 2)) return;
+
+	DynBuckets.Resize(numbuckets * 8);
+	memset(DynBuckets.Data(), -1, DynBuckets.Size() * sizeof(int));
+	for (int i = 0; i < numentries; i++)
+	{
+		HashEntry *entry = GetHashEntry(i);
+		int *bucket = GetBucket(entry->Actor);
+		entry->Next = *bucket;
+		*bucket = i;
+	}
 }
 
 //===========================================================================
@@ -1007,8 +1065,8 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 			}
 			else
 			{
-				size_t hash = ((size_t)me >> 3) % countof(Buckets);
-				for (i = Buckets[hash]; i >= 0; )
+				int *bucket = GetBucket(me);
+				for (i = *bucket; i >= 0; )
 				{
 					entry = GetHashEntry(i);
 					if (entry->Actor == me)
@@ -1022,8 +1080,8 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 					if (NumFixedHash < (int)countof(FixedHash))
 					{
 						entry = &FixedHash[NumFixedHash];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = NumFixedHash++;
+						entry->Next = *bucket;
+						*bucket = NumFixedHash++;
 					}
 					else
 					{
@@ -1033,10 +1091,11 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 						}
 						i = DynHash.Reserve(1);
 						entry = &DynHash[i];
-						entry->Next = Buckets[hash];
-						Buckets[hash] = i + countof(FixedHash);
+						entry->Next = *bucket;
+						*bucket = i + countof(FixedHash);
 					}
 					entry->Actor = me;
+					GrowHash();
 					return me;
 				}
 			}
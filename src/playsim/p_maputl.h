@@ -288,7 +288,11 @@ class FBlockThingsIterator
 
 	FBlockNode *block;
 
+	// Actors that were already returned. The bucket table is replaced by
+	// DynBuckets once it gets crowded, so that queries returning thousands of
+	// actors don't degrade into a linear search.
 	int Buckets[32];
+	TArray<int> DynBuckets;
 
 	struct HashEntry
 	{
@@ -300,6 +304,8 @@ class FBlockThingsIterator
 	TArray<HashEntry> DynHash;
 
 	HashEntry *GetHashEntry(int i) { return i < (int)countof(FixedHash) ? &FixedHash[i] : &DynHash[i - countof(FixedHash)]; }
+	int *GetBucket(AActor *me);
+	void GrowHash();
 
 	void StartBlock(int x, int y);
 	void SwitchBlock(int x, int y);
@@ -36,6 +36,8 @@
 
 #include "g_levellocals.h"
 #include "actorinlines.h"
+#include "ctpl.h"
+#include "superfasthash.h"
 
 static FRandom pr_botchecksight ("BotCheckSight");
 static FRandom pr_checksight ("CheckSight");
@@ -52,7 +54,7 @@ This uses specialized forms of the maputils routines for optimized performance
 
 // Performance meters
 static int sightcounts[6];
-static cycle_t SightCycles;
+cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
 enum
@@ -90,6 +92,103 @@ struct SightTask
 static TArray<intercept_t> intercepts (128);
 static TArray<SightTask> portals(32);
 
+//==========================================================================
+//
+// Prepared sight traces
+//
+// The blockmap walk of a sight check, i.e. which lines get crossed by the
+// trace and in which order, only depends on the trace's end points and the
+// map's static geometry. With the parallel think phase enabled these walks
+// are done on worker threads for the sight checks monsters are likely to
+// make before the thinkers run. P_CheckSight then only needs to apply the
+// checks that depend on mutable state (line flags, sector planes, 3D floors)
+// to the recorded lines, in the same order a full check would do it, so the
+// result is always identical.
+//
+//==========================================================================
+
+struct FPreparedSight
+{
+	AActor *looker;
+	AActor *target;
+	DVector2 start;			// the trace must match exactly for the prepared walk to be used.
+	DVector2 end;
+	int portalgroup;
+	bool blocked;			// the walk stopped before reaching the end point.
+	unsigned firstline;
+	unsigned numlines;
+};
+
+struct FSightRecorder
+{
+	TArray<uint32_t> linestamps;	// replaces line_t::validcount which cannot be used by multiple threads.
+	uint32_t stamp = 0;
+	TArray<line_t *> lines;
+	int counts[6] = {};
+
+	bool Visit(line_t *ld)
+	{
+		auto &ls = linestamps[ld->Index()];
+		if (ls == stamp) return false;
+		ls = stamp;
+		return true;
+	}
+};
+
+using FSightPair = std::pair<AActor *, AActor *>;
+
+template<> struct THashTraits<FSightPair>
+{
+	hash_t Hash(const FSightPair &key)
+	{
+		return (hash_t)SuperFastHash((const char*)(const void*)&key, sizeof(key));
+	}
+	int Compare(const FSightPair &left, const FSightPair &right) { return left != right; }
+};
+
+static struct FSightPrepass
+{
+	FLevelLocals *Level = nullptr;
+	TArray<FPreparedSight> traces;
+	TArray<line_t *> lines;
+	TMap<AActor *, unsigned> bylooker;
+	TMap<FSightPair, unsigned> bypair;		// traces of P_PrepareSightBatch
+	int hits;
+	int misses;
+} SightPrepass;
+
+//==========================================================================
+//
+// Sight memo
+//
+// A walk that ran into a one-sided line fails again for the same trace, no
+// matter what happens to the mutable parts of the map. These traces are
+// remembered for the rest of the tic, so repeated checks between actors that
+// have not moved (e.g. A_Chase testing both melee and missile range) skip
+// the blockmap walk. The key is the trace itself, not the actors.
+//
+//==========================================================================
+
+using FSightTrace = std::pair<DVector2, DVector2>;
+
+template<> struct THashTraits<FSightTrace>
+{
+	hash_t Hash(const FSightTrace &key)
+	{
+		return (hash_t)SuperFastHash((const char*)(const void*)&key, sizeof(key));
+	}
+	int Compare(const FSightTrace &left, const FSightTrace &right) { return left != right; }
+};
+
+static struct FSightMemo
+{
+	FLevelLocals *Level = nullptr;
+	TMap<FSightTrace, bool> blocked;
+	int checks;
+	int memohits;
+	int pvsrejects;
+} SightMemo;
+
 class SightCheck
 {
 	FLevelLocals *Level;
@@ -107,7 +206,11 @@ class SightCheck
 	int portaldir;
 	int portalgroup;
 	bool portalfound;
+	bool staticblock;				// the walk was stopped by a line that always blocks.
 	unsigned int myseethrough;
+	int *counts = sightcounts;
+	FSightRecorder *recorder = nullptr;
+	const FPreparedSight *prepared = nullptr;
 
 	void P_SightOpening(SightOpening &open, const line_t *linedef, double x, double y);
 	bool PTR_SightTraverse (intercept_t *in);
@@ -115,6 +218,8 @@ class SightCheck
 	int P_SightBlockLinesIterator (int x, int y);
 	bool P_SightTraverseIntercepts ();
 	bool LineBlocksSight(line_t *ld);
+	bool P_SightBlockWalk (int &itres);
+	bool P_SightReplayWalk ();
 
 public:
 	SightCheck(FLevelLocals *l)
@@ -123,6 +228,11 @@ public:
 	}
 
 	bool P_SightPathTraverse ();
+	bool P_SightPrepareWalk (FSightRecorder *rec, FPreparedSight &trace);
+	void UsePrepared (const FPreparedSight *trace);
+	bool IsPrepared () const { return prepared != nullptr; }
+	bool IsStaticBlock () const { return staticblock; }
+	FSightTrace GetTrace () const { return { sightstart.XY(), sightend }; }
 
 	void init(AActor * t1, AActor * t2, sector_t *startsector, SightTask *task, int flags)
 	{
@@ -141,6 +251,8 @@ public:
 		Flags = flags;
 		portaldir = task->direction;
 		portalfound = false;
+		staticblock = false;
+		prepared = nullptr;
 
 		myseethrough = FF_SEETHROUGH;
 	}
@@ -434,11 +546,21 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 {
 	divline_t dl;
 
-	if (ld->validcount == validcount)
+	if (recorder != nullptr)
 	{
-		return true;
+		if (!recorder->Visit(ld))
+		{
+			return true;
+		}
+	}
+	else
+	{
+		if (ld->validcount == validcount)
+		{
+			return true;
+		}
+		ld->validcount = validcount;
 	}
-	ld->validcount = validcount;
 	if (P_PointOnDivlineSide (ld->v1->fPos(), &Trace) ==
 		P_PointOnDivlineSide (ld->v2->fPos(), &Trace))
 	{
@@ -451,12 +573,23 @@ bool SightCheck::P_SightCheckLine (line_t *ld)
 		return true;		// line isn't crossed
 	}
 
+	if (recorder != nullptr)
+	{
+		// the line checks are left to the replay of this walk.
+		recorder->lines.Push(ld);
+		return true;
+	}
+
 	if (!portalfound)	// when portals come into play, the quick-outs here may not be performed
 	{
-		if (LineBlocksSight(ld)) return false;
+		if (LineBlocksSight(ld))
+		{
+			staticblock = ld->backsector == nullptr && !(ld->sidedef[0]->Flags & WALLF_POLYOBJ);
+			return false;
+		}
 	}
 
-	sightcounts[3]++;
+	counts[3]++;
 	// store the line for later intersection testing
 	intercept_t newintercept;
 	newintercept.isaline = true;
@@ -619,20 +752,10 @@ bool SightCheck::P_SightTraverseIntercepts ()
 
 bool SightCheck::P_SightPathTraverse ()
 {
-	double x1, x2, y1, y2;
-	double xt1,yt1,xt2,yt2;
-	double xstep,ystep;
-	double partialx, partialy;
-	double xintercept, yintercept;
-	int mapx, mapy, mapxstep, mapystep;
-	int count;
-
 	validcount++;
 	intercepts.Clear ();
-	x1 = sightstart.X + Startfrac * Trace.dx;
-	y1 = sightstart.Y + Startfrac * Trace.dy;
-	x2 = sightend.X;
-	y2 = sightend.Y;
+	double x1 = sightstart.X + Startfrac * Trace.dx;
+	double y1 = sightstart.Y + Startfrac * Trace.dy;
 	if (lastsector == NULL) lastsector = Level->PointInSector(x1, y1);
 
 	// for FF_SEETHROUGH the following rule applies:
@@ -667,6 +790,53 @@ bool SightCheck::P_SightPathTraverse ()
 		portals.Push({ 0, topslope, bottomslope, sector_t::floor, lastsector->GetOppositePortalGroup(sector_t::floor) });
 	}
 
+	if (prepared != nullptr)
+	{
+		return P_SightReplayWalk();
+	}
+
+	int itres;
+	if (!P_SightBlockWalk(itres))
+	{
+		return false;
+	}
+
+//
+// couldn't early out, so go through the sorted list
+//
+sightcounts[2]++;
+
+	bool traverseres = P_SightTraverseIntercepts ( );
+	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
+	if (seeingthing->Sector->PortalGroup != portalgroup) return false;	// We are in a different group than the seeingthing, so this trace cannot determine visibility alone.
+	return traverseres;
+}
+
+/*
+==================
+=
+= P_SightBlockWalk
+=
+= Steps through the map blocks along the trace and collects the crossed lines.
+= Returns false if the trace is blocked before the end.
+==================
+*/
+
+bool SightCheck::P_SightBlockWalk (int &itres)
+{
+	double x1, x2, y1, y2;
+	double xt1,yt1,xt2,yt2;
+	double xstep,ystep;
+	double partialx, partialy;
+	double xintercept, yintercept;
+	int mapx, mapy, mapxstep, mapystep;
+	int count;
+
+	x1 = sightstart.X + Startfrac * Trace.dx;
+	y1 = sightstart.Y + Startfrac * Trace.dy;
+	x2 = sightend.X;
+	y2 = sightend.Y;
+
 	x1 -= Level->blockmap.bmaporgx;
 	y1 -= Level->blockmap.bmaporgy;
 	xt1 = x1 / FBlockmap::MAPBLOCKUNITS;
@@ -748,7 +918,7 @@ bool SightCheck::P_SightPathTraverse ()
 // step through map blocks
 // Count is present to prevent a round off error from skipping the break
 
-	int itres = -1;
+	itres = -1;
 	for (count = 0 ; count < 1000 ; count++)
 	{
 		// end traversing when reaching the end of the blockmap
@@ -760,7 +930,7 @@ bool SightCheck::P_SightPathTraverse ()
 		itres = P_SightBlockLinesIterator(mapx, mapy);
 		if (itres == 0)
 		{
-			sightcounts[1]++;
+			counts[1]++;
 			return false;	// early out
 		}
 
@@ -771,7 +941,7 @@ bool SightCheck::P_SightPathTraverse ()
 		switch (((xs_FloorToInt(yintercept) == mapy) << 1) | (xs_FloorToInt(xintercept) == mapx))
 		{
 		case 0:		// neither xintercept nor yintercept match!
-sightcounts[5]++;
+counts[5]++;
 			// Continuing won't make things any better, so we might as well stop right here
 			return false;
 
@@ -790,7 +960,7 @@ sightcounts[5]++;
 			break;
 
 		case 3:		// xintercept and yintercept both match
-			sightcounts[4]++;
+			counts[4]++;
 			// The trace is exiting a block through its corner. Not only does the block
 			// being entered need to be checked (which will happen when this loop
 			// continues), but the other two blocks adjacent to the corner also need to
@@ -798,7 +968,7 @@ sightcounts[5]++;
 			if (!P_SightBlockLinesIterator (mapx + mapxstep, mapy) ||
 				!P_SightBlockLinesIterator (mapx, mapy + mapystep))
 			{
-sightcounts[1]++;
+counts[1]++;
 				return false;
 			}
 			xintercept += xstep;
@@ -812,15 +982,83 @@ sightcounts[1]++;
 			break;
 		}
 	}
+	return true;
+}
 
+/*
+==================
+=
+= P_SightPrepareWalk
+=
+= Records the blockmap walk for a trace without looking at anything that
+= can change while the thinkers run. This is safe to call from worker threads.
+= Returns false if the walk cannot be replayed later.
+==================
+*/
+
+bool SightCheck::P_SightPrepareWalk (FSightRecorder *rec, FPreparedSight &trace)
+{
+	recorder = rec;
+	counts = rec->counts;
+	rec->stamp++;
+	rec->lines.Clear();
+
+	int itres;
+	trace.blocked = !P_SightBlockWalk(itres);
+	trace.start = sightstart.XY();
+	trace.end = sightend;
+	trace.portalgroup = portalgroup;
+
+	recorder = nullptr;
+	counts = sightcounts;
+
+	// with portals in the way the line checks cannot be separated from the walk.
+	return !portalfound;
+}
+
+void SightCheck::UsePrepared (const FPreparedSight *trace)
+{
+	if (trace->start == sightstart.XY() && trace->end == sightend && trace->portalgroup == portalgroup && Startfrac == 0)
+	{
+		prepared = trace;
+	}
+}
+
+/*
+==================
+=
+= P_SightReplayWalk
+=
+= Applies the line checks to a prepared walk, in the order P_SightBlockWalk
+= would have done them.
+==================
+*/
+
+bool SightCheck::P_SightReplayWalk ()
+{
+	for (unsigned i = 0; i < prepared->numlines; i++)
+	{
+		line_t *ld = SightPrepass.lines[prepared->firstline + i];
+		if (LineBlocksSight(ld))
+		{
+			staticblock = ld->backsector == nullptr;
+			counts[1]++;
+			return false;	// early out
+		}
+		counts[3]++;
+		intercept_t newintercept;
+		newintercept.isaline = true;
+		newintercept.d.line = ld;
+		intercepts.Push (newintercept);
+	}
+	if (prepared->blocked)
+	{
+		return false;
+	}
 
-//
-// couldn't early out, so go through the sorted list
-//
 sightcounts[2]++;
 
 	bool traverseres = P_SightTraverseIntercepts ( );
-	if (itres == -1) return false;	// if the iterator had an early out there was no line of sight. The traverser was only called to collect more portals.
 	if (seeingthing->Sector->PortalGroup != portalgroup) return false;	// We are in a different group than the seeingthing, so this trace cannot determine visibility alone.
 	return traverseres;
 }
@@ -838,11 +1076,40 @@ sightcounts[2]++;
 =====================
 */
 
+static const FPreparedSight *P_FindPreparedSight(AActor *t1, AActor *t2);
+
+//==========================================================================
+//
+// The sight PVS only describes traces between points inside the map, and it
+// relies on the blockmap walk reaching the one-sided line it says is in the
+// way, so the walk must not give up on the trace's length.
+//
+//==========================================================================
+
+static bool P_SightPVSRejects(AActor *t1, AActor *t2)
+{
+	auto Level = t1->Level;
+	if (Level->sightpvs.Size() == 0 || t1->subsector == nullptr || t2->subsector == nullptr) return false;
+	if (Level->CheckSightPVS(t1->subsector->sector, t2->subsector->sector)) return false;
+
+	DVector2 start = t1->Pos().XY(), end = t2->Pos().XY();
+	auto &hulls = Level->subsectorhulls;
+	if (!hulls.Contains(t1->subsector->Index(), start) || !hulls.Contains(t2->subsector->Index(), end)) return false;
+
+	auto &bmap = Level->blockmap;
+	int x1 = xs_FloorToInt((start.X - bmap.bmaporgx) / FBlockmap::MAPBLOCKUNITS);
+	int y1 = xs_FloorToInt((start.Y - bmap.bmaporgy) / FBlockmap::MAPBLOCKUNITS);
+	int x2 = xs_FloorToInt((end.X - bmap.bmaporgx) / FBlockmap::MAPBLOCKUNITS);
+	int y2 = xs_FloorToInt((end.Y - bmap.bmaporgy) / FBlockmap::MAPBLOCKUNITS);
+	return bmap.isValidBlock(x1, y1) && bmap.isValidBlock(x2, y2) && abs(x2 - x1) + abs(y2 - y1) < 990;
+}
+
 int P_CheckSight (AActor *t1, AActor *t2, int flags)
 {
 	SightCycles.Clock();
 
 	bool res;
+	bool fixedtrace;
 
 	if (t1 == nullptr || t2 == nullptr)
 	{
@@ -907,6 +1174,25 @@ sightcounts[0]++;
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
 
+	// Without linked portals the trace runs from t1 to t2 only, so everything
+	// that always blocks it can be looked up.
+	fixedtrace = t1->Level->Displacements.size <= 1;
+	if (fixedtrace)
+	{
+		if (SightMemo.Level != t1->Level)
+		{
+			SightMemo.blocked.Clear();
+			SightMemo.Level = t1->Level;
+		}
+		SightMemo.checks++;
+		if (P_SightPVSRejects(t1, t2))
+		{
+			SightMemo.pvsrejects++;
+			res = false;
+			goto done;
+		}
+	}
+
 	validcount++;
 	portals.Clear();
 	{
@@ -921,7 +1207,24 @@ sightcounts[0]++;
 
 		SightCheck s(t1->Level);
 		s.init(t1, t2, sec, &task, flags);
+		if (fixedtrace && SightMemo.blocked.CheckKey(s.GetTrace()) != nullptr)
+		{
+			SightMemo.memohits++;
+			res = false;
+			goto done;
+		}
+		if (SightPrepass.Level == t1->Level)
+		{
+			auto trace = P_FindPreparedSight(t1, t2);
+			if (trace != nullptr) s.UsePrepared(trace);
+			if (s.IsPrepared()) SightPrepass.hits++;
+			else SightPrepass.misses++;
+		}
 		res = s.P_SightPathTraverse ();
+		if (!res && fixedtrace && s.IsStaticBlock())
+		{
+			SightMemo.blocked[s.GetTrace()] = true;
+		}
 		if (!res)
 		{
 			double dist = t1->Distance2D(t2);
@@ -946,9 +1249,11 @@ done:
 ADD_STAT (sight)
 {
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d, prepared %d/%d, pvs %d memo %d of %d\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5],
+		SightPrepass.hits, SightPrepass.hits + SightPrepass.misses,
+		SightMemo.pvsrejects, SightMemo.memohits, SightMemo.checks);
 	return out;
 }
 
@@ -964,4 +1269,242 @@ void P_ResetSightCounters (bool full)
 	}
 	SightCycles.Reset();
 	memset (sightcounts, 0, sizeof(sightcounts));
+	SightPrepass.hits = SightPrepass.misses = 0;
+	SightMemo.checks = SightMemo.memohits = SightMemo.pvsrejects = 0;
+	SightMemo.blocked.Clear();
+}
+
+//==========================================================================
+//
+// P_PrepareSightChecks
+//
+// Parallel phase of the thinker loop: records the blockmap walks for all
+// monsters looking at their target and at the players.
+//
+//==========================================================================
+
+static ctpl::thread_pool SightPool;
+static TArray<FSightRecorder> SightRecorders;
+
+struct FSightCandidate
+{
+	AActor *looker;
+	AActor *target;
+	sector_t *sec;
+};
+
+static const FPreparedSight *P_FindPreparedSight(AActor *t1, AActor *t2)
+{
+	auto index = SightPrepass.bylooker.CheckKey(t1);
+	if (index != nullptr)
+	{
+		for (unsigned i = *index; i < SightPrepass.traces.Size() && SightPrepass.traces[i].looker == t1; i++)
+		{
+			if (SightPrepass.traces[i].target == t2) return &SightPrepass.traces[i];
+		}
+	}
+	if (SightPrepass.bypair.CountUsed() > 0)
+	{
+		index = SightPrepass.bypair.CheckKey({ t1, t2 });
+		if (index != nullptr) return &SightPrepass.traces[*index];
+	}
+	return nullptr;
+}
+
+static void P_AddSightCandidate(TArray<FSightCandidate> &candidates, FLevelLocals *Level, AActor *looker, AActor *target)
+{
+	if (target == nullptr || target == looker || target->Level != Level) return;
+	if (!Level->CheckReject(looker->Sector, target->Sector)) return;
+
+	sector_t *sec;
+	looker->GetPortalTransition(looker->Z() + looker->Height * 0.75, &sec);
+	candidates.Push({ looker, target, sec });
+}
+
+//==========================================================================
+//
+// Records the walks for the candidates on the worker threads and appends
+// them to SightPrepass in candidate order. Returns the index of the first
+// new trace.
+//
+//==========================================================================
+
+static unsigned P_RecordSightWalks(FLevelLocals *Level, const TArray<FSightCandidate> &candidates, int numthreads)
+{
+	if (SightPool.size() != numthreads)
+	{
+		SightPool.resize(numthreads);
+	}
+	SightRecorders.Resize(numthreads);
+	for (auto &rec : SightRecorders)
+	{
+		if (rec.linestamps.Size() != Level->lines.Size())
+		{
+			rec.linestamps.Resize(Level->lines.Size());
+			memset(rec.linestamps.Data(), 0, rec.linestamps.Size() * sizeof(uint32_t));
+			rec.stamp = 0;
+		}
+	}
+
+	// Each chunk records into its own arrays, which get merged in candidate order afterwards.
+	struct Chunk
+	{
+		unsigned first, last;
+		TArray<FPreparedSight> traces;
+		TArray<line_t *> lines;
+	};
+	const unsigned chunksize = 64;
+	TArray<Chunk> chunks((candidates.Size() + chunksize - 1) / chunksize, true);
+	std::vector<std::future<void>> jobs;
+	for (unsigned c = 0; c < chunks.Size(); c++)
+	{
+		chunks[c].first = c * chunksize;
+		chunks[c].last = min(candidates.Size(), (c + 1) * chunksize);
+		jobs.push_back(SightPool.push([&, c](int threadid)
+		{
+			auto &chunk = chunks[c];
+			auto rec = &SightRecorders[threadid];
+			for (unsigned i = chunk.first; i < chunk.last; i++)
+			{
+				auto &cand = candidates[i];
+				double lookheight = cand.looker->Z() + cand.looker->Height * 0.75;
+				double bottomslope = cand.target->Z() - lookheight;
+				SightTask task = { 0, bottomslope + cand.target->Height, bottomslope, -1, cand.sec->PortalGroup };
+
+				SightCheck s(Level);
+				FPreparedSight trace;
+				s.init(cand.looker, cand.target, cand.sec, &task, 0);
+				if (s.P_SightPrepareWalk(rec, trace))
+				{
+					trace.looker = cand.looker;
+					trace.target = cand.target;
+					trace.firstline = chunk.lines.Size();
+					trace.numlines = rec->lines.Size();
+					chunk.lines.Append(rec->lines);
+					chunk.traces.Push(trace);
+				}
+			}
+		}));
+	}
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+
+	unsigned first = SightPrepass.traces.Size();
+	for (auto &chunk : chunks)
+	{
+		unsigned lineofs = SightPrepass.lines.Size();
+		SightPrepass.lines.Append(chunk.lines);
+		for (auto &trace : chunk.traces)
+		{
+			trace.firstline += lineofs;
+			SightPrepass.traces.Push(trace);
+		}
+	}
+	return first;
+}
+
+void P_PrepareSightChecks(FLevelLocals *Level, int numthreads)
+{
+	P_ClearPreparedSight();
+
+	// Polyobjects can move into the path of a prepared walk while the thinkers run.
+	if (numthreads <= 0 || Level->Polyobjects.Size() > 0)
+		return;
+
+	TArray<FSightCandidate> candidates;
+
+	auto it = Level->GetThinkerIterator<AActor>();
+	AActor *mo;
+	while ((mo = it.Next()))
+	{
+		if (!(mo->flags3 & MF3_ISMONSTER) || mo->health <= 0 || (mo->flags2 & MF2_DORMANT))
+			continue;
+
+		P_AddSightCandidate(candidates, Level, mo, mo->target);
+		for (int i = 0; i < MAXPLAYERS; i++)
+		{
+			if (Level->PlayerInGame(i) && Level->Players[i]->mo != mo->target)
+			{
+				P_AddSightCandidate(candidates, Level, mo, Level->Players[i]->mo);
+			}
+		}
+	}
+	if (candidates.Size() == 0)
+		return;
+
+	// Traces of the same looker are consecutive because the candidates are.
+	for (unsigned i = P_RecordSightWalks(Level, candidates, numthreads); i < SightPrepass.traces.Size(); i++)
+	{
+		auto &trace = SightPrepass.traces[i];
+		if (SightPrepass.bylooker.CheckKey(trace.looker) == nullptr)
+		{
+			SightPrepass.bylooker[trace.looker] = i;
+		}
+	}
+	SightPrepass.Level = Level;
+}
+
+void P_ClearPreparedSight()
+{
+	SightPrepass.Level = nullptr;
+	SightPrepass.traces.Clear();
+	SightPrepass.lines.Clear();
+	SightPrepass.bylooker.Clear();
+	SightPrepass.bypair.Clear();
+}
+
+//==========================================================================
+//
+// P_PrepareSightBatch
+//
+// Records the walks for many actors looking at the same target, like the
+// victims of an explosion, on the think threads. Nothing may move between
+// this and the matching P_ReleaseSightBatch except through code that
+// validates the prepared walks, i.e. P_CheckSight. Batches can be nested
+// but have to be released in reverse order.
+//
+//==========================================================================
+
+void P_PrepareSightBatch(FSightBatch &batch, FLevelLocals *Level, const TArray<AActor *> &lookers, AActor *target, int numthreads)
+{
+	batch.Level = nullptr;
+	if (numthreads <= 0 || lookers.Size() < 16 || Level->Polyobjects.Size() > 0)
+		return;
+
+	TArray<FSightCandidate> candidates;
+	for (auto looker : lookers)
+	{
+		P_AddSightCandidate(candidates, Level, looker, target);
+	}
+	if (candidates.Size() < 16)
+		return;
+
+	batch.Level = Level;
+	batch.PrevLevel = SightPrepass.Level;
+	batch.FirstLine = SightPrepass.lines.Size();
+	batch.FirstTrace = P_RecordSightWalks(Level, candidates, numthreads);
+	for (unsigned i = batch.FirstTrace; i < SightPrepass.traces.Size(); i++)
+	{
+		auto &trace = SightPrepass.traces[i];
+		SightPrepass.bypair[{ trace.looker, trace.target }] = i;
+	}
+	SightPrepass.Level = Level;
+}
+
+void P_ReleaseSightBatch(FSightBatch &batch)
+{
+	if (batch.Level == nullptr)
+		return;
+
+	for (unsigned i = batch.FirstTrace; i < SightPrepass.traces.Size(); i++)
+	{
+		auto &trace = SightPrepass.traces[i];
+		SightPrepass.bypair.Remove({ trace.looker, trace.target });
+	}
+	SightPrepass.traces.Resize(batch.FirstTrace);
+	SightPrepass.lines.Resize(batch.FirstLine);
+	SightPrepass.Level = batch.PrevLevel;
+	batch.Level = nullptr;
 }
@@ -47,11 +47,28 @@
 #include <immintrin.h>
 #endif // ARCH_IA32
 
+enum
+{
+	MAX_RENDER_WORKERS = 8,
+	MAX_RENDER_JOBS = 300000,	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
+};
+
 CVAR(Bool, gl_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
+// Number of worker threads for BSP processing. One of them puts walls, flats and portals into the draw lists in order,
+// the others help processing the walls and flats and share the sprites.
+// 0 picks a count based on the number of available cores.
+CUSTOM_CVAR(Int, gl_multithread_workers, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else if (self > MAX_RENDER_WORKERS) self = MAX_RENDER_WORKERS;
+}
+
 EXTERN_CVAR(Float, r_actorspriteshadowdist)
 
 thread_local bool isWorkerThread;
+thread_local TArray<HWDeferredSprite> *DeferredSprites;
+thread_local HWDeferredOutput *DeferredOutput;
 ctpl::thread_pool renderPool(1);
 bool inited = false;
 
@@ -75,7 +92,7 @@ struct RenderJob
 
 class RenderJobQueue
 {
-	RenderJob pool[300000];	// Way more than ever needed. The largest ever seen on a single viewpoint is around 40000.
+	RenderJob pool[MAX_RENDER_JOBS];
 	std::atomic<int> readindex{};
 	std::atomic<int> writeindex{};
 public:
@@ -92,6 +109,26 @@ public:
 		if (readindex < writeindex) return &pool[readindex++];
 		return nullptr;
 	}
+
+	// Same as GetJob but safe to call from several workers at once.
+	RenderJob *ClaimJob(int &index)
+	{
+		int read = readindex;
+		while (read < writeindex)
+		{
+			if (readindex.compare_exchange_weak(read, read + 1))
+			{
+				index = read;
+				return &pool[read];
+			}
+		}
+		return nullptr;
+	}
+
+	int NumJobs() const
+	{
+		return writeindex;
+	}
 	
 	void ReleaseAll()
 	{
@@ -102,9 +139,231 @@ public:
 
 static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+//==========================================================================
+//
+// With more than one worker the wall and flat jobs also go into a second
+// queue that the extra workers share. Whoever gets to a job first processes
+// it. If that is an extra worker, it records what it would have added to
+// the draw info and the wall worker adds that once it reaches the job, so
+// everything still gets added in the order of the jobs.
+//
+// The sprite and particle jobs go into a third queue for the extra workers.
+// They collect the resulting sprites privately, while the wall worker only
+// records where in the draw lists they would have been added. Once
+// everything is done, the sprites get merged in at these positions.
+//
+// This way the draw lists end up exactly as if a single worker had
+// processed all jobs.
+//
+//==========================================================================
+
+enum
+{
+	WallJobQueued,
+	WallJobClaimed,
+	WallJobDone,
+};
+
+struct SpriteJobMark
+{
+	unsigned translucent, models;	// draw list sizes when the wall worker reached the job
+};
+
+struct SpriteJobResult
+{
+	int worker;
+	unsigned start, end;	// range in the worker's output
+};
+
+static RenderJobQueue wallQueue;
+static std::atomic<uint8_t> wallJobStates[MAX_RENDER_JOBS];
+static HWDeferredOutput::Entry *wallResults[MAX_RENDER_JOBS];
+static HWDeferredOutput wallOutput[MAX_RENDER_WORKERS];
+
+static RenderJobQueue spriteQueue;
+static SpriteJobResult spriteResults[MAX_RENDER_JOBS];
+static TArray<SpriteJobMark> spriteMarks;
+static TArray<HWDeferredSprite> spriteOutput[MAX_RENDER_WORKERS];
+static TArray<HWDrawItem> mergeItems;
+static int extraWorkers;
+
+// A thing touching several sectors must only be processed by the job that comes first.
+// Each sector stores the serial number of its sprite job, the serials of the current
+// RenderBSP call start at firstSpriteSerial. Since the main thread stores them before
+// queuing the job, any job can tell whether a sector's job precedes its own.
+static std::unique_ptr<std::atomic<int>[]> sectorSpriteSerials;
+static unsigned numSectorSpriteSerials;
+static int firstSpriteSerial;
+static thread_local int currentSpriteSerial;
+
+static int NumRenderWorkers()
+{
+	if (gl_multithread_workers > 0) return gl_multithread_workers;
+	return clamp<int>(std::thread::hardware_concurrency() / 2, 1, 4);
+}
+
+static void PrepareExtraJobs(FLevelLocals *Level)
+{
+	wallQueue.ReleaseAll();
+	spriteQueue.ReleaseAll();
+	spriteMarks.Clear();
+
+	unsigned numsectors = Level->sectors.Size();
+	if (numsectors != numSectorSpriteSerials || firstSpriteSerial > INT_MAX - MAX_RENDER_JOBS)
+	{
+		if (numsectors != numSectorSpriteSerials)
+		{
+			sectorSpriteSerials.reset(new std::atomic<int>[numsectors]);
+			numSectorSpriteSerials = numsectors;
+		}
+		for (unsigned i = 0; i < numsectors; i++) sectorSpriteSerials[i].store(-1, std::memory_order_relaxed);
+		firstSpriteSerial = 0;
+	}
+}
+
+static void AddWallJob(int type, subsector_t *sub, seg_t *seg = nullptr)
+{
+	if (extraWorkers > 0)
+	{
+		wallJobStates[wallQueue.NumJobs()].store(WallJobQueued, std::memory_order_relaxed);
+		wallQueue.AddJob(type, sub, seg);
+	}
+	jobQueue.AddJob(type, sub, seg);
+}
+
+static void AddSpriteJob(int type, subsector_t *sub)
+{
+	if (extraWorkers > 0)
+	{
+		if (type == RenderJob::SpriteJob)
+		{
+			sectorSpriteSerials[sub->sector->Index()].store(firstSpriteSerial + spriteQueue.NumJobs(), std::memory_order_relaxed);
+		}
+		spriteQueue.AddJob(type, sub);
+	}
+	jobQueue.AddJob(type, sub);
+}
+
+static bool IsFirstSpriteJob(AActor *thing, sector_t *sector)
+{
+	for (auto node = thing->touching_rendersectors; node != nullptr; node = node->m_tnext)
+	{
+		if (node->m_sector == sector) continue;
+		int serial = sectorSpriteSerials[node->m_sector->Index()].load(std::memory_order_relaxed);
+		if (serial >= firstSpriteSerial && serial < currentSpriteSerial) return false;
+	}
+	return true;
+}
+
+static inline void WaitForJob()
+{
+#ifdef ARCH_IA32
+	// The queue is empty. But yielding would be too costly here and possibly cause further delays down the line if the thread is halted.
+	// So instead add a few pause instructions and retry immediately.
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+	_mm_pause();
+#endif // ARCH_IA32
+}
+
+void HWDrawInfo::ProcessWallJob(subsector_t *sub, seg_t *seg)
 {
 	sector_t *front, *back;
+	HWWall wall;
+	wall.sub = sub;
+
+	front = hw_FakeFlat(sub->sector, in_area, false);
+	auto backsector = seg->backsector;
+	if (!backsector && seg->linedef->isVisualPortal() && seg->sidedef == seg->linedef->sidedef[0]) // For one-sided portals use the portal's destination sector as backsector.
+	{
+		auto portal = seg->linedef->getPortal();
+		backsector = portal->mDestination->frontsector;
+		back = hw_FakeFlat(backsector, in_area, true);
+		if (front->floorplane.isSlope() || front->ceilingplane.isSlope() || back->floorplane.isSlope() || back->ceilingplane.isSlope())
+		{
+			// Having a one-sided portal like this with slopes is too messy so let's ignore that case.
+			back = nullptr;
+		}
+	}
+	else if (backsector)
+	{
+		if (front->sectornum == backsector->sectornum || (seg->sidedef->Flags & WALLF_POLYOBJ))
+		{
+			back = front;
+		}
+		else
+		{
+			back = hw_FakeFlat(backsector, in_area, true);
+		}
+	}
+	else back = nullptr;
+
+	wall.Process(this, seg, front, back);
+}
+
+void HWDrawInfo::ProcessFlatJob(subsector_t *sub)
+{
+	HWFlat flat;
+	flat.section = sub->section;
+	auto front = hw_FakeFlat(sub->render_sector, in_area, false);
+	flat.ProcessSector(this, front);
+}
+
+//==========================================================================
+//
+// Adds what an extra worker recorded for a wall or flat job.
+//
+//==========================================================================
+
+void HWDrawInfo::CommitWallJob(int index)
+{
+	while (wallJobStates[index].load(std::memory_order_acquire) != WallJobDone)
+	{
+		WaitForJob();
+	}
+
+	for (auto entry = wallResults[index]; entry != nullptr; entry = entry->next)
+	{
+		switch (entry->type)
+		{
+		case HWDeferredOutput::Wall:
+			AddWall((HWWall*)entry->data);
+			break;
+
+		case HWDeferredOutput::Portal:
+			((HWWall*)entry->data)->LinkPortal(this, entry->param1, entry->param2);
+			break;
+
+		case HWDeferredOutput::Flat:
+			AddFlat((HWFlat*)entry->data, !!entry->param1);
+			break;
+
+		case HWDeferredOutput::Decal:
+			*AddDecal(!!entry->param1) = *(HWDecal*)entry->data;
+			break;
+
+		case HWDeferredOutput::UpperMissingTexture:
+			AddUpperMissingTexture(entry->side, entry->sub, entry->backheight);
+			break;
+
+		case HWDeferredOutput::LowerMissingTexture:
+			AddLowerMissingTexture(entry->side, entry->sub, entry->backheight);
+			break;
+		}
+	}
+}
+
+void HWDrawInfo::WorkerThread()
+{
+	sector_t *front;
+	int wallJob = 0;
 
 	WTTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
@@ -113,20 +372,7 @@ void HWDrawInfo::WorkerThread()
 		auto job = jobQueue.GetJob();
 		if (job == nullptr)
 		{
-#ifdef ARCH_IA32
-			// The queue is empty. But yielding would be too costly here and possibly cause further delays down the line if the thread is halted.
-			// So instead add a few pause instructions and retry immediately.
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-			_mm_pause();
-#endif // ARCH_IA32
+			WaitForJob();
 		}
 		// Note that the main thread MUST have prepared the fake sectors that get used below!
 		// This worker thread cannot prepare them itself without costly synchronization.
@@ -137,56 +383,36 @@ void HWDrawInfo::WorkerThread()
 			return;
 
 		case RenderJob::WallJob:
+		case RenderJob::FlatJob:
 		{
-			HWWall wall;
-			SetupWall.Clock();
-			wall.sub = job->sub;
-
-			front = hw_FakeFlat(job->sub->sector, in_area, false);
-			auto seg = job->seg;
-			auto backsector = seg->backsector;
-			if (!backsector && seg->linedef->isVisualPortal() && seg->sidedef == seg->linedef->sidedef[0]) // For one-sided portals use the portal's destination sector as backsector.
+			uint8_t state = WallJobQueued;
+			if (extraWorkers > 0 && !wallJobStates[wallJob].compare_exchange_strong(state, WallJobClaimed))
 			{
-				auto portal = seg->linedef->getPortal();
-				backsector = portal->mDestination->frontsector;
-				back = hw_FakeFlat(backsector, in_area, true);
-				if (front->floorplane.isSlope() || front->ceilingplane.isSlope() || back->floorplane.isSlope() || back->ceilingplane.isSlope())
-				{
-					// Having a one-sided portal like this with slopes is too messy so let's ignore that case.
-					back = nullptr;
-				}
+				CommitWallJob(wallJob);
 			}
-			else if (backsector)
+			else if (job->type == RenderJob::WallJob)
 			{
-				if (front->sectornum == backsector->sectornum || (seg->sidedef->Flags & WALLF_POLYOBJ))
-				{
-					back = front;
-				}
-				else
-				{
-					back = hw_FakeFlat(backsector, in_area, true);
-				}
+				SetupWall.Clock();
+				ProcessWallJob(job->sub, job->seg);
+				SetupWall.Unclock();
 			}
-			else back = nullptr;
-
-			wall.Process(this, job->seg, front, back);
-			rendered_lines++;
-			SetupWall.Unclock();
-			break;
-		}
-
-		case RenderJob::FlatJob:
-		{
-			HWFlat flat;
-			SetupFlat.Clock();
-			flat.section = job->sub->section;
-			front = hw_FakeFlat(job->sub->render_sector, in_area, false);
-			flat.ProcessSector(this, front);
-			SetupFlat.Unclock();
+			else
+			{
+				SetupFlat.Clock();
+				ProcessFlatJob(job->sub);
+				SetupFlat.Unclock();
+			}
+			if (job->type == RenderJob::WallJob) rendered_lines++;
+			wallJob++;
 			break;
 		}
 
 		case RenderJob::SpriteJob:
+			if (extraWorkers > 0)
+			{
+				spriteMarks.Push({ drawlists[GLDL_TRANSLUCENT].Size(), drawlists[GLDL_MODELS].Size() });
+				break;
+			}
 			SetupSprite.Clock();
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
 			RenderThings(job->sub, front);
@@ -194,6 +420,11 @@ void HWDrawInfo::WorkerThread()
 			break;
 
 		case RenderJob::ParticleJob:
+			if (extraWorkers > 0)
+			{
+				spriteMarks.Push({ drawlists[GLDL_TRANSLUCENT].Size(), drawlists[GLDL_MODELS].Size() });
+				break;
+			}
 			SetupSprite.Clock();
 			front = hw_FakeFlat(job->sub->sector, in_area, false);
 			RenderParticles(job->sub, front);
@@ -208,6 +439,110 @@ void HWDrawInfo::WorkerThread()
 	}
 }
 
+//==========================================================================
+//
+// Extra worker for wall, flat, sprite and particle jobs. Walls and flats
+// come first because the wall worker waits for them.
+// Nothing here may depend on which job gets processed first.
+//
+//==========================================================================
+
+void HWDrawInfo::ExtraWorkerThread(int worker)
+{
+	isWorkerThread = true;
+	auto &output = wallOutput[worker];
+	auto &sprites = spriteOutput[worker];
+	output.arena.FreeAll();
+	sprites.Clear();
+	DeferredOutput = &output;
+	DeferredSprites = &sprites;
+
+	bool wallsDone = false, spritesDone = false;
+	while (!wallsDone || !spritesDone)
+	{
+		int index;
+		RenderJob *job;
+		if (!wallsDone && (job = wallQueue.ClaimJob(index)) != nullptr)
+		{
+			if (job->type == RenderJob::TerminateJob)
+			{
+				wallsDone = true;
+				continue;
+			}
+			uint8_t state = WallJobQueued;
+			if (!wallJobStates[index].compare_exchange_strong(state, WallJobClaimed)) continue;	// the wall worker already did this one.
+
+			output.first = output.last = nullptr;
+			if (job->type == RenderJob::WallJob) ProcessWallJob(job->sub, job->seg);
+			else ProcessFlatJob(job->sub);
+			wallResults[index] = output.first;
+			wallJobStates[index].store(WallJobDone, std::memory_order_release);
+		}
+		else if (!spritesDone && (job = spriteQueue.ClaimJob(index)) != nullptr)
+		{
+			if (job->type == RenderJob::TerminateJob)
+			{
+				spritesDone = true;
+				continue;
+			}
+			currentSpriteSerial = firstSpriteSerial + index;
+			unsigned start = sprites.Size();
+			auto front = hw_FakeFlat(job->sub->sector, in_area, false);
+			if (job->type == RenderJob::SpriteJob) RenderThings(job->sub, front);
+			else RenderParticles(job->sub, front);
+			spriteResults[index] = { worker, start, sprites.Size() };
+		}
+		else
+		{
+			WaitForJob();
+		}
+	}
+	DeferredOutput = nullptr;
+	DeferredSprites = nullptr;
+}
+
+//==========================================================================
+//
+// Inserts the sprites of the extra workers into the draw lists
+//
+//==========================================================================
+
+void HWDrawInfo::MergeSpriteJobs()
+{
+	static const int lists[] = { GLDL_TRANSLUCENT, GLDL_MODELS };
+	unsigned numjobs = spriteMarks.Size();
+
+	unsigned count = 0;
+	for (unsigned i = 0; i < numjobs; i++) count += spriteResults[i].end - spriteResults[i].start;
+	if (count == 0) return;
+	rendered_sprites += count;
+
+	for (int listnum : lists)
+	{
+		auto &list = drawlists[listnum];
+		mergeItems.Clear();
+		mergeItems.Swap(list.drawitems);
+
+		unsigned pos = 0;
+		for (unsigned i = 0; i < numjobs; i++)
+		{
+			unsigned mark = listnum == GLDL_TRANSLUCENT ? spriteMarks[i].translucent : spriteMarks[i].models;
+			for (; pos < mark; pos++) list.drawitems.Push(mergeItems[pos]);
+
+			auto &result = spriteResults[i];
+			auto &output = spriteOutput[result.worker];
+			for (unsigned j = result.start; j < result.end; j++)
+			{
+				if (output[j].list != listnum) continue;
+				auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
+				*sprite = output[j].sprite;
+				list.drawitems.Push(HWDrawItem(DrawType_SPRITE, list.sprites.Push(sprite)));
+			}
+		}
+		for (; pos < mergeItems.Size(); pos++) list.drawitems.Push(mergeItems[pos]);
+	}
+}
+
 
 
 
@@ -343,7 +678,7 @@ void HWDrawInfo::AddLine (seg_t *seg, bool portalclip)
 		{
 			if (multithread)
 			{
-				jobQueue.AddJob(RenderJob::WallJob, seg->Subsector, seg);
+				AddWallJob(RenderJob::WallJob, seg->Subsector, seg);
 			}
 			else
 			{
@@ -527,8 +862,12 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 	for (auto p = sec->touching_renderthings; p != nullptr; p = p->m_snext)
 	{
 		auto thing = p->m_thing;
-		if (thing->validcount == validcount) continue;
-		thing->validcount = validcount;
+		if (DeferredSprites == nullptr)
+		{
+			if (thing->validcount == validcount) continue;
+			thing->validcount = validcount;
+		}
+		else if (!IsFirstSpriteJob(thing, sec)) continue;
 
 		FIntCVar *cvar = thing->GetInfo()->distancecheck;
 		if (cvar != nullptr && *cvar >= 0)
@@ -593,8 +932,7 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 
 void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 {
-	SetupSprite.Clock();
-	for (int i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
+	for (uint32_t i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
 	{
 		if (mClipPortal)
 		{
@@ -605,7 +943,6 @@ void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 		HWSprite sprite;
 		sprite.ProcessParticle(this, &Level->Particles[i], front);
 	}
-	SetupSprite.Unclock();
 }
 
 
@@ -670,7 +1007,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 	{
 		if (multithread)
 		{
-			jobQueue.AddJob(RenderJob::ParticleJob, sub, nullptr);
+			AddSpriteJob(RenderJob::ParticleJob, sub);
 		}
 		else
 		{
@@ -696,7 +1033,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 		{
 			if (multithread)
 			{
-				jobQueue.AddJob(RenderJob::SpriteJob, sub, nullptr);
+				AddSpriteJob(RenderJob::SpriteJob, sub);
 			}
 			else
 			{
@@ -733,7 +1070,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::FlatJob, sub);
+						AddWallJob(RenderJob::FlatJob, sub);
 					}
 					else
 					{
@@ -844,17 +1181,42 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
+		// Actors seen through line portals get moved temporarily by the wall worker, so they cannot be processed in parallel.
+		extraWorkers = Level->PortalBlockmap.containsLines ? 0 : NumRenderWorkers() - 1;
+		if (renderPool.size() < extraWorkers + 1) renderPool.resize(extraWorkers + 1);
+
 		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
+		if (extraWorkers > 0) PrepareExtraJobs(Level);
+
+		std::future<void> futures[MAX_RENDER_WORKERS];
+		futures[0] = renderPool.push([&](int id) {
 			WorkerThread();
 		});
+		for (int i = 1; i <= extraWorkers; i++)
+		{
+			futures[i] = renderPool.push([this, i](int id) {
+				ExtraWorkerThread(i);
+			});
+		}
 		RenderBSPNode(node);
 
 		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		for (int i = 1; i <= extraWorkers; i++)
+		{
+			wallQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+			spriteQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		}
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		for (int i = 0; i <= extraWorkers; i++) futures[i].wait();
 		MTWait.Unclock();
+
+		if (extraWorkers > 0)
+		{
+			MergeSpriteJobs();
+			firstSpriteSerial += spriteQueue.NumJobs();
+			extraWorkers = 0;
+		}
 	}
 	else
 	{
@@ -421,6 +421,12 @@ HWPortal * HWDrawInfo::FindPortal(const void * src)
 
 HWDecal *HWDrawInfo::AddDecal(bool onmirror)
 {
+	if (DeferredOutput != nullptr)
+	{
+		auto decal = (HWDecal*)DeferredOutput->arena.Alloc(sizeof(HWDecal));
+		DeferredOutput->Add(HWDeferredOutput::Decal, onmirror)->data = decal;
+		return decal;
+	}
 	auto decal = (HWDecal*)RenderDataAllocator.Alloc(sizeof(HWDecal));
 	Decals[onmirror ? 1 : 0].Push(decal);
 	return decal;
@@ -192,6 +192,11 @@ private:
 	sector_t *currentsector;
 
 	void WorkerThread();
+	void ExtraWorkerThread(int worker);
+	void ProcessWallJob(subsector_t *sub, seg_t *seg);
+	void ProcessFlatJob(subsector_t *sub);
+	void CommitWallJob(int index);
+	void MergeSpriteJobs();
 
 	void UnclipSubsector(subsector_t *sub);
 	
@@ -583,18 +583,73 @@ void HWDrawList::SortSpriteIntoWall(HWDrawInfo *di, SortNode * head,SortNode * s
 
 //==========================================================================
 //
+// Sprites are drawn back to front. Sprites at the same depth are drawn
+// in the order they were processed, or the reverse of that with
+// COMPATF_SPRITESORT. This packs both into one key so that sorting the
+// keys in ascending order yields the draw order.
 //
+//==========================================================================
+
+struct SpriteSortEntry
+{
+	uint64_t key;
+	SortNode *node;
+};
+
+static inline uint64_t SpriteSortKey(const HWSprite *s, bool reverse)
+{
+	float depth = s->depth;
+	if (depth == 0) depth = 0;	// -0 must end up in the same place as 0.
+
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	bits = (bits & 0x80000000) ? bits : ~bits & 0x7fffffff;	// descending depth
+
+	uint32_t index = uint32_t(s->index) ^ 0x80000000;
+	if (reverse) index = ~index;
+	return (uint64_t(bits) << 32) | index;
+}
+
+//==========================================================================
+//
+// Stable LSD radix sort. Passes where all keys share the same digit are
+// skipped, which is most of the upper ones for typical depth ranges.
 //
 //==========================================================================
 
-inline int HWDrawList::CompareSprites(SortNode * a,SortNode * b)
+static void RadixSortSprites(TArray<SpriteSortEntry> &list, TArray<SpriteSortEntry> &temp)
 {
-	HWSprite * s1= sprites[drawitems[a->itemindex].index];
-	HWSprite * s2= sprites[drawitems[b->itemindex].index];
+	unsigned count = list.Size();
+	unsigned histogram[8][256] = {};
+
+	for (auto &entry : list)
+	{
+		for (int pass = 0; pass < 8; pass++) histogram[pass][(entry.key >> (pass * 8)) & 255]++;
+	}
+
+	temp.Resize(count);
+	auto src = list.Data();
+	auto dest = temp.Data();
+	for (int pass = 0; pass < 8; pass++)
+	{
+		unsigned *offsets = histogram[pass];
+		int shift = pass * 8;
+		if (offsets[(src[0].key >> shift) & 255] == count) continue;
 
-	if (s1->depth < s2->depth) return 1;
-	if (s1->depth > s2->depth) return -1;
-	return reverseSort? s2->index-s1->index : s1->index-s2->index;
+		unsigned sum = 0;
+		for (int i = 0; i < 256; i++)
+		{
+			unsigned c = offsets[i];
+			offsets[i] = sum;
+			sum += c;
+		}
+		for (unsigned i = 0; i < count; i++)
+		{
+			dest[offsets[(src[i].key >> shift) & 255]++] = src[i];
+		}
+		std::swap(src, dest);
+	}
+	if (src != list.Data()) memcpy(list.Data(), src, count * sizeof(SpriteSortEntry));
 }
 
 //==========================================================================
@@ -605,27 +660,37 @@ inline int HWDrawList::CompareSprites(SortNode * a,SortNode * b)
 SortNode * HWDrawList::SortSpriteList(SortNode * head)
 {
 	SortNode * n;
-	int count;
 	unsigned i;
 
-	static TArray<SortNode*> sortspritelist;
+	static TArray<SpriteSortEntry> sortspritelist;
+	static TArray<SpriteSortEntry> sorttemp;
 
 	SortNode * parent=head->parent;
 
 	sortspritelist.Clear();
-	for(count=0,n=head;n;n=n->next) sortspritelist.Push(n);
-	std::stable_sort(sortspritelist.begin(), sortspritelist.end(), [=](SortNode *a, SortNode *b)
+	for(n=head;n;n=n->next) sortspritelist.Push({ SpriteSortKey(sprites[drawitems[n->itemindex].index], reverseSort), n });
+
+	// Not worth the histogram setup for short lists.
+	if (sortspritelist.Size() < 64)
 	{
-		return CompareSprites(a, b) < 0;
-	});
+		std::stable_sort(sortspritelist.begin(), sortspritelist.end(), [](const SpriteSortEntry &a, const SpriteSortEntry &b)
+		{
+			return a.key < b.key;
+		});
+	}
+	else
+	{
+		RadixSortSprites(sortspritelist, sorttemp);
+	}
 
 	for(i=0;i<sortspritelist.Size();i++)
 	{
-		sortspritelist[i]->next=NULL;
-		if (parent) parent->equal=sortspritelist[i];
-		parent=sortspritelist[i];
+		auto node = sortspritelist[i].node;
+		node->next=NULL;
+		if (parent) parent->equal=node;
+		parent=node;
 	}
-	return sortspritelist[0];
+	return sortspritelist[0].node;
 }
 
 //==========================================================================
@@ -711,7 +776,15 @@ void HWDrawList::Sort(HWDrawInfo *di)
 	reverseSort = !!(di->Level->i_compatflags & COMPATF_SPRITESORT);
     SortZ = di->Viewpoint.Pos.Z;
 	MakeSortList();
-	sorted = DoSort(di, SortNodes[SortNodeStart]);
+	if (walls.Size() == 0 && flats.Size() == 0)
+	{
+		// Nothing to split against, so there is no need to look for a splitter first.
+		sorted = SortSpriteList(SortNodes[SortNodeStart]);
+	}
+	else
+	{
+		sorted = DoSort(di, SortNodes[SortNodeStart]);
+	}
 }
 
 //==========================================================================
@@ -940,7 +1013,9 @@ void HWDrawList::DrawSorted(HWDrawInfo *di, FRenderState &state)
 	if (!sorted)
 	{
 		screen->mVertexData->Map();
+		SortItems.Clock();
 		Sort(di);
+		SortItems.Unclock();
 		screen->mVertexData->Unmap();
 	}
 	state.ClearClipSplit();
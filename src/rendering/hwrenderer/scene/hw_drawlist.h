@@ -104,7 +104,6 @@ public:
 	void SortSpriteIntoPlane(SortNode * head,SortNode * sort);
 	void SortWallIntoWall(HWDrawInfo *di, SortNode * head,SortNode * sort);
 	void SortSpriteIntoWall(HWDrawInfo *di, SortNode * head,SortNode * sort);
-	int CompareSprites(SortNode * a,SortNode * b);
 	SortNode * SortSpriteList(SortNode * head);
 	SortNode * DoSort(HWDrawInfo *di, SortNode * head);
 	void Sort(HWDrawInfo *di);
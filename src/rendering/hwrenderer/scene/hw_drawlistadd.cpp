@@ -28,6 +28,7 @@
 #include "hw_material.h"
 #include "actor.h"
 #include "g_levellocals.h"
+#include "hw_clock.h"
 
 EXTERN_CVAR(Bool, gl_seamless)
 
@@ -39,6 +40,13 @@ EXTERN_CVAR(Bool, gl_seamless)
 
 void HWDrawInfo::AddWall(HWWall *wall)
 {
+	if (DeferredOutput != nullptr)
+	{
+		auto entry = DeferredOutput->Add(HWDeferredOutput::Wall);
+		entry->data = DeferredOutput->Copy(wall);
+		return;
+	}
+
 	if (wall->flags & HWWall::HWF_TRANSLUCENT)
 	{
 		auto newwall = drawlists[GLDL_TRANSLUCENT].NewWall();
@@ -105,6 +113,13 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 {
 	int list;
 
+	if (DeferredOutput != nullptr)
+	{
+		auto entry = DeferredOutput->Add(HWDeferredOutput::Flat, fog);
+		entry->data = DeferredOutput->Copy(flat);
+		return;
+	}
+
 	if (flat->renderstyle != STYLE_Translucent || flat->alpha < 1.f - FLT_EPSILON || fog || flat->texture == nullptr)
 	{
 		// translucent 3D floors go into the regular translucent list, translucent portals go into the translucent border list.
@@ -132,6 +147,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 	}
 	auto newflat = drawlists[list].NewFlat();
 	*newflat = *flat;
+	rendered_flats++;
 }
 
 
@@ -153,7 +169,14 @@ void HWDrawInfo::AddSprite(HWSprite *sprite, bool translucent)
 		list = GLDL_MODELS;
 	}
 
+	if (DeferredSprites != nullptr)
+	{
+		DeferredSprites->Push({ list, *sprite });
+		return;
+	}
+
 	auto newsprt = drawlists[list].NewSprite();
 	*newsprt = *sprite;
+	rendered_sprites++;
 }
 
@@ -8,6 +8,7 @@
 #include "renderstyle.h"
 #include "textures.h"
 #include "r_data/colormaps.h"
+#include "memarena.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4244)
@@ -206,6 +207,7 @@ public:
 
 	void PutWall(HWDrawInfo *di, bool translucent);
 	void PutPortal(HWDrawInfo *di, int ptype, int plane);
+	void LinkPortal(HWDrawInfo *di, int ptype, int plane);
 	void CheckTexturePosition(FTexCoordInfo *tci);
 
 	void Put3DWall(HWDrawInfo *di, lightlist_t * lightlist, bool translucent);
@@ -394,6 +396,16 @@ public:
 	void DrawSprite(HWDrawInfo *di, FRenderState &state, bool translucent);
 };
 
+// A sprite that was processed by one of the extra BSP workers.
+// RenderBSP merges these into the draw lists once all workers are done.
+struct HWDeferredSprite
+{
+	int list;
+	HWSprite sprite;
+};
+
+extern thread_local TArray<HWDeferredSprite> *DeferredSprites;
+
 
 
 
@@ -425,6 +437,58 @@ struct HWDecal
 
 };
 
+// What one of the extra BSP workers produced for a wall or flat job. Everything that
+// would change the draw info gets recorded here, so that the wall worker can add it
+// in job order. The wall worker reads this while the extra worker is still adding more
+// so everything is allocated from the arena, which never moves anything.
+struct HWDeferredOutput
+{
+	enum
+	{
+		Wall,
+		Portal,
+		Flat,
+		Decal,
+		UpperMissingTexture,
+		LowerMissingTexture,
+	};
+
+	struct Entry
+	{
+		Entry *next;
+		int type;
+		int param1, param2;		// fog flag for flats, mirror flag for decals, portal type and plane for portals
+		void *data;				// the wall, flat or decal
+		side_t *side;			// for the missing texture hacks
+		subsector_t *sub;
+		float backheight;
+	};
+
+	FMemArena arena;
+	Entry *first = nullptr, *last = nullptr;	// of the job that's currently being processed
+
+	Entry *Add(int type, int param1 = 0, int param2 = 0)
+	{
+		auto entry = (Entry*)arena.Calloc(sizeof(Entry));
+		entry->type = type;
+		entry->param1 = param1;
+		entry->param2 = param2;
+		if (last != nullptr) last->next = entry;
+		else first = entry;
+		last = entry;
+		return entry;
+	}
+
+	template<class T> T *Copy(const T *obj)
+	{
+		auto copy = (T*)arena.Alloc(sizeof(T));
+		*copy = *obj;
+		return copy;
+	}
+};
+
+extern thread_local HWDeferredOutput *DeferredOutput;
+
 
 inline float Dist2(float x1,float y1,float x2,float y2)
 {
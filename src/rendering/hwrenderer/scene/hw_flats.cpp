@@ -440,7 +440,6 @@ void HWFlat::Process(HWDrawInfo *di, sector_t * model, int whichplane, bool fog)
 
 	// For hacks this won't go into a render list.
 	PutFlat(di, fog);
-	rendered_flats++;
 }
 
 //==========================================================================
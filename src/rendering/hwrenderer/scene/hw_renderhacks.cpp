@@ -194,6 +194,15 @@ void HWDrawInfo::AddOtherCeilingPlane(int sector, gl_subsectorrendernode * node)
 //==========================================================================
 void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (DeferredOutput != nullptr)
+	{
+		auto entry = DeferredOutput->Add(HWDeferredOutput::UpperMissingTexture);
+		entry->side = side;
+		entry->sub = sub;
+		entry->backheight = Backheight;
+		return;
+	}
+
 	if (!side->segs[0]->backsector) return;
 
 	for (int i = 0; i < side->numsegs; i++)
@@ -246,6 +255,15 @@ void HWDrawInfo::AddUpperMissingTexture(side_t * side, subsector_t *sub, float B
 //==========================================================================
 void HWDrawInfo::AddLowerMissingTexture(side_t * side, subsector_t *sub, float Backheight)
 {
+	if (DeferredOutput != nullptr)
+	{
+		auto entry = DeferredOutput->Add(HWDeferredOutput::LowerMissingTexture);
+		entry->side = side;
+		entry->sub = sub;
+		entry->backheight = Backheight;
+		return;
+	}
+
 	sector_t *backsec = side->segs[0]->backsector;
 	if (!backsec) return;
 	if (backsec->transdoor)
@@ -210,6 +210,7 @@ void HWDrawInfo::GetDynSpriteLight(AActor *thing, particle_t *particle, float *o
 // static so that we build up a reserve (memory allocations stop)
 // For multithread processing each worker thread needs its own copy, though.
 static thread_local TArray<FDynamicLight*> addedLightsArray; 
+static thread_local TArray<FSection*> checkedSectionsArray;
 
 void hw_GetDynModelLight(AActor *self, FDynLightData &modellightdata)
 {
@@ -218,20 +219,23 @@ void hw_GetDynModelLight(AActor *self, FDynLightData &modellightdata)
 	if (self)
 	{
 		auto &addedLights = addedLightsArray;	// avoid going through the thread local storage for each use.
+		auto &checkedSections = checkedSectionsArray;
 
 		addedLights.Clear();
+		checkedSections.Clear();
 
 		float x = (float)self->X();
 		float y = (float)self->Y();
 		float z = (float)self->Center();
 		float actorradius = (float)self->RenderRadius();
 		float radiusSquared = actorradius * actorradius;
-		dl_validcount++;
 
 		BSPWalkCircle(self->Level, x, y, radiusSquared, [&](subsector_t *subsector) // Iterate through all subsectors potentially touched by actor
 		{
 			auto section = subsector->section;
-			if (section->validcount == dl_validcount) return;	// already done from a previous subsector.
+			// This can run on several sprite workers at once so it cannot use the section's validcount.
+			if (std::find(checkedSections.begin(), checkedSections.end(), section) != checkedSections.end()) return;	// already done from a previous subsector.
+			checkedSections.Push(section);
 			FLightNode * node = section->lighthead;
 			while (node) // check all lights touching a subsector
 			{
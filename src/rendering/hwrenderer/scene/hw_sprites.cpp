@@ -1233,7 +1233,6 @@ void HWSprite::Process(HWDrawInfo *di, AActor* thing, sector_t * sector, area_t
 	}
 
 	PutSprite(di, hw_styleflags != STYLEHW_Solid);
-	rendered_sprites++;
 }
 
 
@@ -1387,7 +1386,6 @@ void HWSprite::ProcessParticle (HWDrawInfo *di, particle_t *particle, sector_t *
 		lightlist = nullptr;
 
 	PutSprite(di, hw_styleflags != STYLEHW_Solid);
-	rendered_sprites++;
 }
 
 //==========================================================================
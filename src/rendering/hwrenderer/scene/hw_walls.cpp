@@ -564,10 +564,45 @@ void HWWall::PutWall(HWDrawInfo *di, bool translucent)
 //==========================================================================
 
 void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
+{
+	MakeVertices(di, false);
+	if (ptype == PORTALTYPE_LINETOLINE && !lineportal) return;
+
+	if (DeferredOutput != nullptr)
+	{
+		// The portals are shared by all walls so they can only be looked up once the wall worker gets to this.
+		auto entry = DeferredOutput->Add(HWDeferredOutput::Portal, ptype, plane);
+		auto wall = DeferredOutput->Copy(this);
+		// The sky and horizon info belong to the caller. These need to be bitwise copies because the unique lists compare them with memcmp.
+		if (ptype == PORTALTYPE_SKY)
+		{
+			wall->sky = (HWSkyInfo*)DeferredOutput->arena.Alloc(sizeof(HWSkyInfo));
+			memcpy(wall->sky, sky, sizeof(HWSkyInfo));
+		}
+		else if (ptype == PORTALTYPE_HORIZON)
+		{
+			wall->horizon = (HWHorizonInfo*)DeferredOutput->arena.Alloc(sizeof(HWHorizonInfo));
+			memcpy(wall->horizon, horizon, sizeof(HWHorizonInfo));
+		}
+		entry->data = wall;
+	}
+	else
+	{
+		LinkPortal(di, ptype, plane);
+	}
+	vertcount = 0;
+}
+
+//==========================================================================
+//
+// 
+//
+//==========================================================================
+
+void HWWall::LinkPortal(HWDrawInfo *di, int ptype, int plane)
 {
 	HWPortal * portal = nullptr;
 
-	MakeVertices(di, false);
 	switch (ptype)
 	{
 		// portals don't go into the draw list.
@@ -638,8 +673,6 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 		break;
 
 	case PORTALTYPE_LINETOLINE:
-		if (!lineportal)
-			return;
 		portal = di->FindPortal(lineportal);
 		if (!portal)
 		{
@@ -665,7 +698,6 @@ void HWWall::PutPortal(HWDrawInfo *di, int ptype, int plane)
 		portal->AddLine(this);
 		break;
 	}
-	vertcount = 0;
 
 	if (plane != -1 && portal)
 	{
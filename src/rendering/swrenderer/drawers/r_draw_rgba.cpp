@@ -59,10 +59,13 @@
 #include "r_draw_sprite32_sse2.h"
 #include "r_draw_span32_sse2.h"
 #include "r_draw_sky32_sse2.h"
+#include "r_draw_wall32_avx2.h"
+#include "r_draw_span32_avx2.h"
 #endif
 
 #include "gi.h"
 #include "stats.h"
+#include "x86.h"
 #include <vector>
 
 ;
@@ -78,36 +81,98 @@ CVAR(Bool, r_mipmap, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 // Level of detail texture bias
 CVAR(Float, r_lod_bias, -1.5, 0); // To do: add CVAR_ARCHIVE | CVAR_GLOBALCONFIG when a good default has been decided
 
+// Use the AVX2 wall and span drawers if the CPU supports them
+CVAR(Bool, r_avx2drawers, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
 namespace swrenderer
 {
+#ifdef NO_SSE
+	typedef DrawWall32Command DrawWall32AVX2Command;
+	typedef DrawWallMasked32Command DrawWallMasked32AVX2Command;
+	typedef DrawWallAddClamp32Command DrawWallAddClamp32AVX2Command;
+	typedef DrawWallSubClamp32Command DrawWallSubClamp32AVX2Command;
+	typedef DrawWallRevSubClamp32Command DrawWallRevSubClamp32AVX2Command;
+	typedef DrawSpan32Command DrawSpan32AVX2Command;
+	typedef DrawSpanMasked32Command DrawSpanMasked32AVX2Command;
+	typedef DrawSpanTranslucent32Command DrawSpanTranslucent32AVX2Command;
+	typedef DrawSpanAddClamp32Command DrawSpanAddClamp32AVX2Command;
+
+	bool SWTruecolorDrawers::AVX2Supported()
+	{
+		return false;
+	}
+#else
+	bool SWTruecolorDrawers::AVX2Supported()
+	{
+		// The OS must also save the upper halves of the YMM registers on context switches.
+		static bool supported = []()
+		{
+			if (!CPU.bAVX2 || !CPU.bOSXSAVE)
+				return false;
+#ifdef _MSC_VER
+			uint64_t xcr0 = _xgetbv(0);
+#else
+			uint32_t eax, edx;
+			__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			uint64_t xcr0 = ((uint64_t)edx << 32) | eax;
+#endif
+			return (xcr0 & 6) == 6;
+		}();
+		return supported;
+	}
+#endif
+
+	bool SWTruecolorDrawers::UseAVX2()
+	{
+		return r_avx2drawers && AVX2Supported();
+	}
+
 	void SWTruecolorDrawers::DrawWall(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWall32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWall32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWall32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallMasked(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallMasked32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWallMasked32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWallMasked32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAdd(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallAddClamp32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWallAddClamp32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWallAddClamp32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAddClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallAddClamp32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWallAddClamp32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWallAddClamp32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallSubClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallSubClamp32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWallSubClamp32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWallSubClamp32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawWallRevSubClamp(const WallDrawerArgs &args)
 	{
-		DrawWallColumns<DrawWallRevSubClamp32Command>(args);
+		if (UseAVX2())
+			DrawWallColumns<DrawWallRevSubClamp32AVX2Command>(args);
+		else
+			DrawWallColumns<DrawWallRevSubClamp32Command>(args);
 	}
 	
 	void SWTruecolorDrawers::DrawColumn(const SpriteDrawerArgs &args)
@@ -206,32 +271,50 @@ namespace swrenderer
 
 	void SWTruecolorDrawers::DrawSpan(const SpanDrawerArgs &args)
 	{
-		DrawSpan32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpan32AVX2Command::DrawColumn(args);
+		else
+			DrawSpan32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMasked(const SpanDrawerArgs &args)
 	{
-		DrawSpanMasked32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpanMasked32AVX2Command::DrawColumn(args);
+		else
+			DrawSpanMasked32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanTranslucent(const SpanDrawerArgs &args)
 	{
-		DrawSpanTranslucent32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpanTranslucent32AVX2Command::DrawColumn(args);
+		else
+			DrawSpanTranslucent32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedTranslucent(const SpanDrawerArgs &args)
 	{
-		DrawSpanAddClamp32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpanAddClamp32AVX2Command::DrawColumn(args);
+		else
+			DrawSpanAddClamp32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanAddClamp(const SpanDrawerArgs &args)
 	{
-		DrawSpanTranslucent32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpanTranslucent32AVX2Command::DrawColumn(args);
+		else
+			DrawSpanTranslucent32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedAddClamp(const SpanDrawerArgs &args)
 	{
-		DrawSpanAddClamp32Command::DrawColumn(args);
+		if (UseAVX2())
+			DrawSpanAddClamp32AVX2Command::DrawColumn(args);
+		else
+			DrawSpanAddClamp32Command::DrawColumn(args);
 	}
 	
 	void SWTruecolorDrawers::DrawSingleSkyColumn(const SkyDrawerArgs &args)
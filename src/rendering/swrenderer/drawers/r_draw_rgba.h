@@ -71,6 +71,43 @@ namespace swrenderer
 	#define VECTORCALL
 	#endif
 
+	// Allows AVX2 instructions in functions of an SSE2 build. They may only be called if the CPU supports AVX2
+	#if defined(__GNUC__)
+	#define AVX2_TARGET __attribute__((target("avx2")))
+	#else
+	#define AVX2_TARGET
+	#endif
+
+#ifndef NO_SSE
+	// Four pixels with 16 bits per channel, as used by the AVX2 drawers
+	class AVX2Pixels
+	{
+	public:
+		// The same channel values for all pixels
+		AVX2_TARGET FORCEINLINE static __m256i VECTORCALL Channels(int a, int r, int g, int b)
+		{
+			return _mm256_set_epi16(a, r, g, b, a, r, g, b, a, r, g, b, a, r, g, b);
+		}
+
+		// One value for all channels of each pixel
+		AVX2_TARGET FORCEINLINE static __m256i VECTORCALL Values(int v0, int v1, int v2, int v3)
+		{
+			const int64_t all = 0x0001000100010001LL;
+			return _mm256_setr_epi64x(v0 * all, v1 * all, v2 * all, v3 * all);
+		}
+
+		AVX2_TARGET FORCEINLINE static __m256i VECTORCALL Unpack(__m128i color)
+		{
+			return _mm256_cvtepu8_epi16(color);
+		}
+
+		AVX2_TARGET FORCEINLINE static __m128i VECTORCALL Pack(__m256i color)
+		{
+			return _mm_packus_epi16(_mm256_castsi256_si128(color), _mm256_extracti128_si256(color, 1));
+		}
+	};
+#endif
+
 	template<typename CommandType, typename BlendMode>
 	class DrawerBlendCommand : public CommandType
 	{
@@ -136,6 +173,10 @@ namespace swrenderer
 		void DrawScaledFuzzColumn(const SpriteDrawerArgs& args);
 		void DrawUnscaledFuzzColumn(const SpriteDrawerArgs& args);
 
+		// True if the CPU and the OS support the AVX2 wall and span drawers
+		static bool AVX2Supported();
+		static bool UseAVX2();
+
 		template<typename DrawerT> void DrawWallColumns(const WallDrawerArgs& args);
 		template<typename DrawerT> void DrawWallColumn32(WallColumnDrawerArgs& drawerargs, int x, int y1, int y2, uint32_t texelX, uint32_t texelY, uint32_t texelStepX, uint32_t texelStepY);
 
@@ -0,0 +1,403 @@
+/*
+** r_draw_span32_avx2.h
+**
+** AVX2 drawer commands for spans
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Same as DrawSpan32T but shades and blends four pixels per step. Texture
+** sampling is shared with the SSE2 version.
+**
+*/
+
+#pragma once
+
+#include "swrenderer/drawers/r_draw_span32_sse2.h"
+
+namespace swrenderer
+{
+	template<typename BlendT>
+	class DrawSpan32AVX2T
+	{
+	public:
+		typedef typename DrawSpan32T<BlendT>::TextureData TextureData;
+
+		AVX2_TARGET static void DrawColumn(const SpanDrawerArgs& args)
+		{
+			using namespace DrawSpan32TModes;
+
+			TextureData texdata;
+			texdata.width = args.TextureWidth();
+			texdata.height = args.TextureHeight();
+			texdata.xstep = args.TextureUStep();
+			texdata.ystep = args.TextureVStep();
+			texdata.xfrac = args.TextureUPos();
+			texdata.yfrac = args.TextureVPos();
+
+			texdata.source = (const uint32_t*)args.TexturePixels();
+
+			double lod = args.TextureLOD();
+			bool mipmapped = args.MipmappedTexture();
+
+			bool magnifying = lod < 0.0;
+			if (r_mipmap && mipmapped)
+			{
+				int level = (int)lod;
+				while (level > 0)
+				{
+					if (texdata.width <= 2 || texdata.height <= 2)
+						break;
+
+					texdata.source += texdata.width * texdata.height;
+					texdata.width = max<uint32_t>(texdata.width / 2, 1);
+					texdata.height = max<uint32_t>(texdata.height / 2, 1);
+					level--;
+				}
+			}
+
+			texdata.xone = (0x80000000u / texdata.width) << 1;
+			texdata.yone = (0x80000000u / texdata.height) << 1;
+
+			bool is_nearest_filter = (magnifying && !r_magfilter) || (!magnifying && !r_minfilter);
+			bool is_64x64 = texdata.width == 64 && texdata.height == 64;
+
+			auto shade_constants = args.ColormapConstants();
+			if (shade_constants.simple_shade)
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<SimpleShade, NearestFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<SimpleShade, NearestFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<SimpleShade, LinearFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<SimpleShade, LinearFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+			}
+			else
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, NearestFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<AdvancedShade, NearestFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, LinearFilter, TextureSize64x64>(args, texdata, shade_constants);
+					else
+						Loop<AdvancedShade, LinearFilter, TextureSizeAny>(args, texdata, shade_constants);
+				}
+			}
+		}
+
+		template<typename FilterModeT, typename TextureSizeT>
+		FORCEINLINE static uint32_t Sample(TextureData &texdata)
+		{
+			uint32_t color = DrawSpan32T<BlendT>::template Sample<FilterModeT, TextureSizeT>(texdata.width, texdata.height, texdata.xone, texdata.yone, texdata.xstep, texdata.ystep, texdata.xfrac, texdata.yfrac, texdata.source);
+			texdata.xfrac += texdata.xstep;
+			texdata.yfrac += texdata.ystep;
+			return color;
+		}
+
+		template<typename ShadeModeT, typename FilterModeT, typename TextureSizeT>
+		AVX2_TARGET FORCEINLINE static void VECTORCALL Loop(const SpanDrawerArgs& args, TextureData texdata, ShadeConstants shade_constants)
+		{
+			using namespace DrawSpan32TModes;
+
+			// Shade constants
+			int light = 256 - (args.Light() >> (FRACBITS - 8));
+			__m256i mlight = AVX2Pixels::Channels(256, light, light, light);
+			__m256i inv_light = AVX2Pixels::Channels(0, 256 - light, 256 - light, 256 - light);
+
+			__m256i inv_desaturate, shade_fade, shade_light;
+			int desaturate;
+			if (ShadeModeT::Mode == (int)ShadeMode::Advanced)
+			{
+				// Same channel order as the SSE2 version so that both draw the same image.
+				int inv = 256 - shade_constants.desaturate;
+				inv_desaturate = AVX2Pixels::Channels(inv, inv, inv, 256);
+				shade_fade = AVX2Pixels::Channels(shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue);
+				shade_fade = _mm256_mullo_epi16(shade_fade, inv_light);
+				shade_light = AVX2Pixels::Channels(shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue);
+				desaturate = shade_constants.desaturate;
+			}
+			else
+			{
+				inv_desaturate = _mm256_setzero_si256();
+				shade_fade = _mm256_setzero_si256();
+				shade_light = _mm256_setzero_si256();
+				desaturate = 0;
+			}
+
+			auto lights = args.dc_lights;
+			auto num_lights = args.dc_num_lights;
+			float vpx = args.dc_viewpos.X;
+			float stepvpx = args.dc_viewpos_step.X;
+			__m128 viewpos_x = _mm_setr_ps(vpx, vpx + stepvpx, vpx + stepvpx * 2.0f, vpx + stepvpx * 3.0f);
+			__m128 step_viewpos_x = _mm_set1_ps(stepvpx * 4.0f);
+
+			int count = args.DestX2() - args.DestX1() + 1;
+			uint32_t *dest = (uint32_t*)args.Viewport()->GetDest(args.DestX1(), args.DestY());
+
+			if (FilterModeT::Mode == (int)FilterModes::Linear)
+			{
+				texdata.xfrac -= texdata.xone / 2;
+				texdata.yfrac -= texdata.yone / 2;
+			}
+
+			uint32_t srcalpha = args.SrcAlpha() >> (FRACBITS - 8);
+			uint32_t destalpha = args.DestAlpha() >> (FRACBITS - 8);
+
+			int avxcount = count / 4;
+			for (int index = 0; index < avxcount; index++)
+			{
+				int offset = index * 4;
+
+				__m256i bgcolor;
+				if (BlendT::Mode != (int)SpanBlendModes::Opaque)
+				{
+					bgcolor = AVX2Pixels::Unpack(_mm_loadu_si128((const __m128i*)(dest + offset)));
+				}
+				else
+				{
+					bgcolor = _mm256_setzero_si256();
+				}
+
+				uint32_t ifgcolor[4];
+				for (int i = 0; i < 4; i++)
+				{
+					ifgcolor[i] = Sample<FilterModeT, TextureSizeT>(texdata);
+				}
+
+				__m256i fgcolor = AVX2Pixels::Unpack(_mm_loadu_si128((const __m128i*)ifgcolor));
+				fgcolor = Shade<ShadeModeT>(fgcolor, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, viewpos_x);
+				__m128i outcolor = Blend(fgcolor, bgcolor, srcalpha, destalpha, ifgcolor);
+
+				_mm_storeu_si128((__m128i*)(dest + offset), outcolor);
+				viewpos_x = _mm_add_ps(viewpos_x, step_viewpos_x);
+			}
+
+			int remaining = count - avxcount * 4;
+			if (remaining > 0)
+			{
+				int offset = avxcount * 4;
+
+				uint32_t desttmp[4] = { 0, 0, 0, 0 };
+				uint32_t ifgcolor[4] = { 0, 0, 0, 0 };
+				for (int i = 0; i < remaining; i++)
+				{
+					desttmp[i] = dest[offset + i];
+					ifgcolor[i] = Sample<FilterModeT, TextureSizeT>(texdata);
+				}
+
+				__m256i bgcolor;
+				if (BlendT::Mode != (int)SpanBlendModes::Opaque)
+				{
+					bgcolor = AVX2Pixels::Unpack(_mm_loadu_si128((const __m128i*)desttmp));
+				}
+				else
+				{
+					bgcolor = _mm256_setzero_si256();
+				}
+
+				__m256i fgcolor = AVX2Pixels::Unpack(_mm_loadu_si128((const __m128i*)ifgcolor));
+				fgcolor = Shade<ShadeModeT>(fgcolor, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, viewpos_x);
+				_mm_storeu_si128((__m128i*)desttmp, Blend(fgcolor, bgcolor, srcalpha, destalpha, ifgcolor));
+
+				for (int i = 0; i < remaining; i++)
+				{
+					dest[offset + i] = desttmp[i];
+				}
+			}
+		}
+
+		template<typename ShadeModeT>
+		AVX2_TARGET FORCEINLINE static __m256i VECTORCALL Shade(__m256i fgcolor, __m256i mlight, int desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light, const DrawerLight *lights, int num_lights, __m128 viewpos_x)
+		{
+			using namespace DrawSpan32TModes;
+
+			__m256i material = fgcolor;
+			if (ShadeModeT::Mode == (int)ShadeMode::Simple)
+			{
+				fgcolor = _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, mlight), 8);
+			}
+			else
+			{
+				// intensity = ((red * 77 + green * 143 + blue * 37) >> 8) * desaturate, in the color channels of each pixel
+				__m256i intensity = _mm256_madd_epi16(fgcolor, _mm256_set1_epi64x(0x0000004d008f0025LL));
+				intensity = _mm256_add_epi32(intensity, _mm256_shuffle_epi32(intensity, _MM_SHUFFLE(2, 3, 0, 1)));
+				intensity = _mm256_mullo_epi16(_mm256_srli_epi32(intensity, 8), _mm256_set1_epi16(desaturate));
+				intensity = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(intensity, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+				intensity = _mm256_blend_epi16(intensity, _mm256_setzero_si256(), 0x88);
+
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(fgcolor, inv_desaturate), intensity), 8);
+				fgcolor = _mm256_mullo_epi16(fgcolor, mlight);
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(shade_fade, fgcolor), 8);
+				fgcolor = _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, shade_light), 8);
+			}
+
+			return AddLights(material, fgcolor, lights, num_lights, viewpos_x);
+		}
+
+		AVX2_TARGET FORCEINLINE static __m256i VECTORCALL AddLights(__m256i material, __m256i fgcolor, const DrawerLight *lights, int num_lights, __m128 viewpos_x)
+		{
+			using namespace DrawSpan32TModes;
+
+			__m256i lit = _mm256_setzero_si256();
+
+			for (int i = 0; i != num_lights; i++)
+			{
+				__m128 light_x = _mm_set1_ps(lights[i].x);
+				__m128 light_y = _mm_set1_ps(lights[i].y);
+				__m128 light_z = _mm_set1_ps(lights[i].z);
+				__m128 light_radius = _mm_set1_ps(lights[i].radius);
+				__m128 m256 = _mm_set1_ps(256.0f);
+
+				// L = light-pos
+				// dist = sqrt(dot(L, L))
+				// distance_attenuation = 1 - min(dist * (1/radius), 1)
+				__m128 Lyz2 = light_y; // L.y*L.y + L.z*L.z
+				__m128 Lx = _mm_sub_ps(light_x, viewpos_x);
+				__m128 dist2 = _mm_add_ps(Lyz2, _mm_mul_ps(Lx, Lx));
+				__m128 rcp_dist = _mm_rsqrt_ps(dist2);
+				__m128 dist = _mm_mul_ps(dist2, rcp_dist);
+				__m128 distance_attenuation = _mm_sub_ps(m256, _mm_min_ps(_mm_mul_ps(dist, light_radius), m256));
+
+				// The simple light type
+				__m128 simple_attenuation = distance_attenuation;
+
+				// The point light type
+				// diffuse = dot(N,L) * attenuation
+				__m128 point_attenuation = _mm_mul_ps(_mm_mul_ps(light_z, rcp_dist), distance_attenuation);
+
+				__m128 is_attenuated = _mm_cmpeq_ps(light_z, _mm_setzero_ps());
+				__m128i attenuation = _mm_cvtps_epi32(_mm_blendv_ps(point_attenuation, simple_attenuation, is_attenuated));
+
+				// Saturate to 16 bits like the SSE2 version and copy to all channels of the pixel
+				__m256i pixel_attenuation = _mm256_cvtepi16_epi64(_mm_packs_epi32(attenuation, attenuation));
+				pixel_attenuation = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixel_attenuation, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+
+				__m256i light_color = AVX2Pixels::Unpack(_mm_set1_epi32(lights[i].color));
+
+				lit = _mm256_add_epi16(lit, _mm256_srli_epi16(_mm256_mullo_epi16(light_color, pixel_attenuation), 8));
+			}
+
+			lit = _mm256_min_epi16(lit, _mm256_set1_epi16(256));
+
+			fgcolor = _mm256_add_epi16(fgcolor, _mm256_srli_epi16(_mm256_mullo_epi16(material, lit), 8));
+			fgcolor = _mm256_min_epi16(fgcolor, _mm256_set1_epi16(255));
+			return fgcolor;
+		}
+
+		AVX2_TARGET FORCEINLINE static __m128i VECTORCALL Blend(__m256i fgcolor, __m256i bgcolor, uint32_t srcalpha, uint32_t destalpha, const uint32_t *ifgcolor)
+		{
+			using namespace DrawSpan32TModes;
+
+			if (BlendT::Mode == (int)SpanBlendModes::Opaque)
+			{
+				return _mm_or_si128(AVX2Pixels::Pack(fgcolor), _mm_set1_epi32(0xff000000));
+			}
+			else if (BlendT::Mode == (int)SpanBlendModes::Masked)
+			{
+				__m128i fg = AVX2Pixels::Pack(fgcolor);
+				__m128i mask = _mm_cmpeq_epi32(fg, _mm_setzero_si128());
+				__m128i outcolor = _mm_blendv_epi8(fg, AVX2Pixels::Pack(bgcolor), mask);
+				return _mm_or_si128(outcolor, _mm_set1_epi32(0xff000000));
+			}
+			else
+			{
+				__m256i fgalpha, bgalpha;
+				if (BlendT::Mode == (int)SpanBlendModes::Translucent)
+				{
+					fgalpha = _mm256_set1_epi16(srcalpha);
+					bgalpha = _mm256_set1_epi16(destalpha);
+				}
+				else
+				{
+					int fga[4], bga[4];
+					for (int i = 0; i < 4; i++)
+					{
+						uint32_t alpha = APART(ifgcolor[i]);
+						alpha += alpha >> 7; // 255->256
+						uint32_t inv_alpha = 256 - alpha;
+						bga[i] = (destalpha * alpha + (inv_alpha << 8) + 128) >> 8;
+						fga[i] = (srcalpha * alpha + 128) >> 8;
+					}
+					fgalpha = AVX2Pixels::Values(fga[0], fga[1], fga[2], fga[3]);
+					bgalpha = AVX2Pixels::Values(bga[0], bga[1], bga[2], bga[3]);
+				}
+
+				fgcolor = _mm256_mullo_epi16(fgcolor, fgalpha);
+				bgcolor = _mm256_mullo_epi16(bgcolor, bgalpha);
+
+				__m256i fg_lo = _mm256_unpacklo_epi16(fgcolor, _mm256_setzero_si256());
+				__m256i bg_lo = _mm256_unpacklo_epi16(bgcolor, _mm256_setzero_si256());
+				__m256i fg_hi = _mm256_unpackhi_epi16(fgcolor, _mm256_setzero_si256());
+				__m256i bg_hi = _mm256_unpackhi_epi16(bgcolor, _mm256_setzero_si256());
+
+				__m256i out_lo, out_hi;
+				if (BlendT::Mode == (int)SpanBlendModes::Translucent || BlendT::Mode == (int)SpanBlendModes::AddClamp)
+				{
+					out_lo = _mm256_add_epi32(fg_lo, bg_lo);
+					out_hi = _mm256_add_epi32(fg_hi, bg_hi);
+				}
+				else if (BlendT::Mode == (int)SpanBlendModes::SubClamp)
+				{
+					out_lo = _mm256_sub_epi32(fg_lo, bg_lo);
+					out_hi = _mm256_sub_epi32(fg_hi, bg_hi);
+				}
+				else if (BlendT::Mode == (int)SpanBlendModes::RevSubClamp)
+				{
+					out_lo = _mm256_sub_epi32(bg_lo, fg_lo);
+					out_hi = _mm256_sub_epi32(bg_hi, fg_hi);
+				}
+
+				out_lo = _mm256_srai_epi32(out_lo, 8);
+				out_hi = _mm256_srai_epi32(out_hi, 8);
+				__m256i outcolor = _mm256_packs_epi32(out_lo, out_hi);
+				return _mm_or_si128(AVX2Pixels::Pack(outcolor), _mm_set1_epi32(0xff000000));
+			}
+		}
+	};
+
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::OpaqueSpan> DrawSpan32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::MaskedSpan> DrawSpanMasked32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::TranslucentSpan> DrawSpanTranslucent32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::AddClampSpan> DrawSpanAddClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::SubClampSpan> DrawSpanSubClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::RevSubClampSpan> DrawSpanRevSubClamp32AVX2Command;
+}
@@ -0,0 +1,339 @@
+/*
+** r_drawbench.cpp
+**
+** Micro-benchmark for the true color wall and span drawers
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Maintainers and Contributors
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Every kernel draws a synthetic frame with the SSE2 and the AVX2 drawers
+** into two framebuffers that start out with the same contents. The drawers
+** are called directly, so the timings do not include wall and plane setup.
+**
+*/
+
+#include "doomstat.h"
+#include "v_video.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "stats.h"
+#include "printf.h"
+#include "swrenderer/drawers/r_draw_rgba.h"
+#include "swrenderer/r_swcolormaps.h"
+#include "swrenderer/viewport/r_viewport.h"
+#ifndef NO_SSE
+#include "swrenderer/drawers/r_draw_wall32_avx2.h"
+#include "swrenderer/drawers/r_draw_span32_avx2.h"
+#endif
+
+EXTERN_CVAR(Bool, r_magfilter)
+EXTERN_CVAR(Bool, r_minfilter)
+
+#ifndef NO_SSE
+
+namespace swrenderer
+{
+	enum
+	{
+		BenchWidth = 640,
+		BenchHeight = 400,
+		BenchTextureSize = 128,
+	};
+
+	struct FDrawerBench
+	{
+		RenderViewport Viewport;
+		FSWColormap NormalColormap;
+		FSWColormap FogColormap;
+		TArray<uint32_t> WallTexture;
+		TArray<uint32_t> SpanTexture;
+		DrawerLight SpanLights[2];
+	};
+
+	struct FDrawerBenchCase
+	{
+		const char *Name;
+		void (*Draw[2])(FDrawerBench &bench, const FDrawerBenchCase &test);
+		bool Masked, Additive;
+		fixed_t Alpha;
+		bool Linear, Fog, Lights;
+	};
+
+	//==========================================================================
+	//
+	// One light right in front of the wall and one simple light
+	//
+	//==========================================================================
+
+	static void SetBenchWallLights(WallColumnDrawerArgs &args, int x)
+	{
+		float dx = float(x - BenchWidth / 2);
+
+		args.dc_viewpos.Z = BenchHeight / 4.0f;
+		args.dc_viewpos_step.Z = -0.5f;
+		args.dc_num_lights = 2;
+		for (int i = 0; i < 2; i++)
+		{
+			auto &light = args.dc_lights[i];
+			light.x = dx * dx + 40.0f * 40.0f;
+			light.y = i == 0 ? 40.0f : 0.0f;
+			light.z = 0.0f;
+			light.radius = 256.0f / 300.0f;
+			light.color = i == 0 ? 0xff8040 : 0x4080ff;
+		}
+	}
+
+	template<typename DrawerT>
+	static void DrawBenchWalls(FDrawerBench &bench, const FDrawerBenchCase &test)
+	{
+		WallDrawerArgs wallargs;
+		wallargs.SetStyle(test.Masked, test.Additive, test.Alpha, test.Lights);
+		wallargs.SetDest(&bench.Viewport);
+		wallargs.SetBaseColormap(test.Fog ? &bench.FogColormap : &bench.NormalColormap);
+
+		WallColumnDrawerArgs args;
+		args.wallargs = &wallargs;
+		args.SetTextureVStep((fixed_t)(uint32_t)(4294967296.0 * 1.5 / BenchHeight));
+
+		const uint32_t *pixels = bench.WallTexture.Data();
+		for (int x = 0; x < BenchWidth; x++)
+		{
+			int tx = x % BenchTextureSize;
+			const uint32_t *source = pixels + tx * BenchTextureSize;
+			const uint32_t *source2 = pixels + ((tx + 1) % BenchTextureSize) * BenchTextureSize;
+
+			args.SetDest(x, 0);
+			args.SetCount(BenchHeight);
+			args.SetTexture((const uint8_t*)source, test.Linear ? (const uint8_t*)source2 : nullptr, BenchTextureSize);
+			args.SetTextureUPos(test.Linear ? x * 5 % 16 : 0);
+			args.SetTextureVPos((fixed_t)(x * 0x1000000u));
+			args.SetLight(x * 12.0f / BenchWidth, 16 << FRACBITS);
+			if (test.Lights)
+				SetBenchWallLights(args, x);
+			else
+				args.dc_num_lights = 0;
+
+			DrawerT::DrawColumn(args);
+		}
+	}
+
+	template<typename DrawerT>
+	static void DrawBenchSpans(FDrawerBench &bench, const FDrawerBenchCase &test)
+	{
+		SpanDrawerArgs args;
+		args.SetStyle(test.Masked, test.Additive, test.Alpha, nullptr);
+		args.SetBaseColormap(test.Fog ? &bench.FogColormap : &bench.NormalColormap);
+
+		// Linear filtering is used when the texture is minified, the 64x64 case only when it is magnified.
+		if (test.Linear)
+		{
+			args.SetTexture(bench.SpanTexture.Data(), BenchTextureSize, BenchTextureSize);
+			args.SetTextureLOD(1.0);
+		}
+		else
+		{
+			args.SetTexture(bench.SpanTexture.Data(), 64, 64);
+			args.SetTextureLOD(-1.0);
+		}
+		args.SetTextureUStep(0.8 / 64);
+		args.SetTextureVStep(0.1 / 64);
+		args.dc_lights = bench.SpanLights;
+		args.dc_viewpos.X = -BenchWidth / 2.0f;
+		args.dc_viewpos_step.X = 1.0f;
+
+		for (int y = 0; y < BenchHeight; y++)
+		{
+			float dy = float(y - BenchHeight / 2);
+			for (auto &light : bench.SpanLights)
+			{
+				light.y = dy * dy + 50.0f * 50.0f;
+			}
+			args.dc_num_lights = test.Lights ? 2 : 0;
+
+			args.SetDestY(&bench.Viewport, y);
+			args.SetDestX1(0);
+			args.SetDestX2(BenchWidth - 1);
+			args.SetTextureUPos(y * 0.01);
+			args.SetTextureVPos(y / 64.0);
+			args.SetLight(y * 12.0f / BenchHeight, 16 << FRACBITS);
+			DrawerT::DrawColumn(args);
+		}
+	}
+
+	//==========================================================================
+	//
+	//
+	//
+	//==========================================================================
+
+	static void InitDrawerBench(FDrawerBench &bench)
+	{
+		bench.NormalColormap.Color = PalEntry(0, 255, 255, 255);
+		bench.NormalColormap.Fade = 0;
+		bench.FogColormap.Color = PalEntry(0, 255, 224, 192);
+		bench.FogColormap.Fade = PalEntry(0, 64, 80, 96);
+		bench.FogColormap.Desaturate = 64;
+
+		// Some holes for the masked drawers
+		uint32_t seed = 12345;
+		bench.WallTexture.Resize(BenchTextureSize * BenchTextureSize);
+		for (auto &pixel : bench.WallTexture)
+		{
+			seed = seed * 1664525 + 1013904223;
+			pixel = (seed >> 24) < 16 ? 0 : (seed >> 8) | 0xff000000;
+		}
+		bench.SpanTexture = bench.WallTexture;
+
+		for (int i = 0; i < 2; i++)
+		{
+			auto &light = bench.SpanLights[i];
+			light.x = 0.0f;
+			light.z = i == 0 ? 30.0f : 0.0f;
+			light.radius = 256.0f / 300.0f;
+			light.color = i == 0 ? 0xff8040 : 0x4080ff;
+		}
+	}
+
+	static void ClearBenchCanvas(DCanvas &canvas)
+	{
+		uint32_t seed = 54321;
+		auto pixels = (uint32_t*)canvas.GetPixels();
+		int count = canvas.GetPitch() * canvas.GetHeight();
+		for (int i = 0; i < count; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			pixels[i] = (seed >> 8) | 0xff000000;
+		}
+	}
+
+	static int CompareBenchCanvas(DCanvas &a, DCanvas &b)
+	{
+		auto pa = a.GetPixels();
+		auto pb = b.GetPixels();
+		int count = a.GetPitch() * a.GetHeight() * 4;
+		int maxdiff = 0;
+		for (int i = 0; i < count; i++)
+		{
+			maxdiff = max(maxdiff, abs(pa[i] - pb[i]));
+		}
+		return maxdiff;
+	}
+
+	//==========================================================================
+	//
+	// Returns the best time of several runs in milliseconds per frame.
+	//
+	//==========================================================================
+
+	static double RunDrawerBench(FDrawerBench &bench, const FDrawerBenchCase &test, int drawer, int frames)
+	{
+		double best = 0;
+		for (int run = 0; run < 5; run++)
+		{
+			cycle_t clock;
+			clock.Reset();
+			clock.Clock();
+			for (int i = 0; i < frames; i++)
+			{
+				test.Draw[drawer](bench, test);
+			}
+			clock.Unclock();
+
+			double ms = clock.TimeMS() / frames;
+			if (run == 0 || ms < best) best = ms;
+		}
+		return best;
+	}
+
+	static const FDrawerBenchCase DrawerBenchCases[] =
+	{
+		{ "wall", { DrawBenchWalls<DrawWall32Command>, DrawBenchWalls<DrawWall32AVX2Command> }, false, false, OPAQUE, false, false, false },
+		{ "wall linear", { DrawBenchWalls<DrawWall32Command>, DrawBenchWalls<DrawWall32AVX2Command> }, false, false, OPAQUE, true, false, false },
+		{ "wall fog", { DrawBenchWalls<DrawWall32Command>, DrawBenchWalls<DrawWall32AVX2Command> }, false, false, OPAQUE, false, true, false },
+		{ "wall dynlights", { DrawBenchWalls<DrawWall32Command>, DrawBenchWalls<DrawWall32AVX2Command> }, false, false, OPAQUE, false, false, true },
+		{ "wall masked", { DrawBenchWalls<DrawWallMasked32Command>, DrawBenchWalls<DrawWallMasked32AVX2Command> }, true, false, OPAQUE, false, false, false },
+		{ "wall addclamp", { DrawBenchWalls<DrawWallAddClamp32Command>, DrawBenchWalls<DrawWallAddClamp32AVX2Command> }, false, true, OPAQUE * 2 / 3, false, false, false },
+		{ "span", { DrawBenchSpans<DrawSpan32Command>, DrawBenchSpans<DrawSpan32AVX2Command> }, false, false, OPAQUE, false, false, false },
+		{ "span linear", { DrawBenchSpans<DrawSpan32Command>, DrawBenchSpans<DrawSpan32AVX2Command> }, false, false, OPAQUE, true, false, false },
+		{ "span fog", { DrawBenchSpans<DrawSpan32Command>, DrawBenchSpans<DrawSpan32AVX2Command> }, false, false, OPAQUE, false, true, false },
+		{ "span dynlights", { DrawBenchSpans<DrawSpan32Command>, DrawBenchSpans<DrawSpan32AVX2Command> }, false, false, OPAQUE, false, false, true },
+		{ "span translucent", { DrawBenchSpans<DrawSpanTranslucent32Command>, DrawBenchSpans<DrawSpanTranslucent32AVX2Command> }, false, false, OPAQUE / 2, false, false, false },
+		{ "span addclamp", { DrawBenchSpans<DrawSpanAddClamp32Command>, DrawBenchSpans<DrawSpanAddClamp32AVX2Command> }, false, true, OPAQUE * 2 / 3, false, false, false },
+	};
+}
+
+#endif
+
+CCMD(swdrawbench)
+{
+#ifdef NO_SSE
+	Printf("This build has no SSE2 or AVX2 drawers\n");
+#else
+	using namespace swrenderer;
+
+	if (!SWTruecolorDrawers::AVX2Supported())
+	{
+		Printf("This CPU does not support AVX2\n");
+		return;
+	}
+
+	int frames = argv.argc() > 1 ? max(1, (int)strtol(argv[1], nullptr, 0)) : 10;
+
+	// The drawers add the view window offset to all coordinates.
+	DCanvas canvas[2] = { { viewwindowx + BenchWidth, viewwindowy + BenchHeight, true }, { viewwindowx + BenchWidth, viewwindowy + BenchHeight, true } };
+
+	FDrawerBench bench;
+	InitDrawerBench(bench);
+
+	bool magfilter = r_magfilter, minfilter = r_minfilter;
+	r_magfilter = false;
+	r_minfilter = true;
+
+	Printf("%dx%d, %d frames, MPixels per second\n", BenchWidth, BenchHeight, frames);
+	for (auto &test : DrawerBenchCases)
+	{
+		double ms[2];
+		for (int drawer = 0; drawer < 2; drawer++)
+		{
+			ClearBenchCanvas(canvas[drawer]);
+			bench.Viewport.RenderTarget = &canvas[drawer];
+			ms[drawer] = RunDrawerBench(bench, test, drawer, frames);
+		}
+		bench.Viewport.RenderTarget = nullptr;
+
+		double mpixels = BenchWidth * BenchHeight / 1000.;
+		int maxdiff = CompareBenchCanvas(canvas[0], canvas[1]);
+		FString diff;
+		if (maxdiff > 0) diff.Format(" max difference %d", maxdiff);
+		Printf("%-20s %8.1f SSE2 %8.1f AVX2 (%.2fx)%s\n", test.Name, ms[0] > 0 ? mpixels / ms[0] : 0., ms[1] > 0 ? mpixels / ms[1] : 0., ms[1] > 0 ? ms[0] / ms[1] : 0., diff.GetChars());
+	}
+
+	r_magfilter = magfilter;
+	r_minfilter = minfilter;
+#endif
+}
@@ -5,6 +5,7 @@
 #include "drawers/r_draw.cpp"
 #include "drawers/r_draw_pal.cpp"
 #include "drawers/r_draw_rgba.cpp"
+#include "drawers/r_drawbench.cpp"
 #include "line/r_fogboundary.cpp"
 #include "line/r_line.cpp"
 #include "line/r_farclip_line.cpp"
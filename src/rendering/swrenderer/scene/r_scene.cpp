@@ -63,15 +63,26 @@ EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
 CVAR(Int, r_scene_multithreaded, 1, 0);
+CVAR(Int, r_scene_tilesperthread, 4, 0);
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 namespace swrenderer
 {
-	cycle_t WallCycles, PlaneCycles, MaskedCycles;
+	cycle_t WallCycles, PlaneCycles, MaskedCycles, SceneCycles;
+
+	struct RenderThreadTiming
+	{
+		double BusyMS;
+		int Tiles;
+	};
+	static TArray<RenderThreadTiming> ThreadTimings;
 	
 	RenderScene::RenderScene()
 	{
 		Threads.push_back(std::unique_ptr<RenderThread>(new RenderThread(this)));
+		TileQueues.push_back(std::make_unique<RenderTileQueue>());
+		TileViewport.reset(new RenderViewport());
+		TileLight.reset(new LightVisibility());
 	}
 
 	RenderScene::~RenderScene()
@@ -186,14 +197,22 @@ namespace swrenderer
 			StartThreads(numThreads);
 		}
 
+		// Split the view into more column tiles than there are threads, so that threads finishing early can steal work from busier ones
+		int tilesPerThread = numThreads > 1 ? clamp((int)r_scene_tilesperthread, 1, 64) : 1;
+		numTiles = clamp(numThreads * tilesPerThread, numThreads, max(viewwidth / 16, numThreads));
+
+		SceneCycles.ResetAndClock();
+
 		// Setup threads:
 		std::unique_lock<std::mutex> start_lock(start_mutex);
+		*TileViewport = *MainThread()->Viewport;
+		*TileLight = *MainThread()->Light;
 		for (int i = 0; i < numThreads; i++)
 		{
-			*Threads[i]->Viewport = *MainThread()->Viewport;
-			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
+			TileQueues[i]->front = numTiles * i / numThreads;
+			TileQueues[i]->back = numTiles * (i + 1) / numThreads;
+			TileQueues[i]->BusyCycles.Reset();
+			TileQueues[i]->TilesRendered = 0;
 		}
 		run_id++;
 		FSoftwareTexture::CurrentUpdate = run_id;
@@ -206,7 +225,7 @@ namespace swrenderer
 		}
 
 		// Do the main thread ourselves:
-		RenderThreadSlice(MainThread());
+		RenderThreadTiles(0);
 
 		// Wait for everyone to finish:
 		if (Threads.size() > 1)
@@ -221,11 +240,89 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		SceneCycles.Unclock();
+
+		ThreadTimings.Resize(numThreads);
+		for (int i = 0; i < numThreads; i++)
+		{
+			ThreadTimings[i].BusyMS = TileQueues[i]->BusyCycles.TimeMS();
+			ThreadTimings[i].Tiles = TileQueues[i]->TilesRendered;
+		}
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
 	}
 
+	void RenderScene::RenderThreadTiles(int threadIndex)
+	{
+		RenderThread *thread = Threads[threadIndex].get();
+		RenderTileQueue *queue = TileQueues[threadIndex].get();
+
+		int tile;
+		while (NextTile(threadIndex, tile))
+		{
+			queue->BusyCycles.Clock();
+
+			// Portals and mirrors modify the viewport, so every tile starts from the saved frame setup
+			*thread->Viewport = *TileViewport;
+			*thread->Light = *TileLight;
+			thread->X1 = viewwidth * tile / numTiles;
+			thread->X2 = viewwidth * (tile + 1) / numTiles;
+			RenderThreadSlice(thread);
+
+			queue->BusyCycles.Unclock();
+			queue->TilesRendered++;
+		}
+	}
+
+	bool RenderScene::NextTile(int threadIndex, int &tile)
+	{
+		// Work through our own tiles from the front first
+		{
+			RenderTileQueue *queue = TileQueues[threadIndex].get();
+			std::unique_lock<std::mutex> lock(queue->mutex);
+			if (queue->front < queue->back)
+			{
+				tile = queue->front++;
+				return true;
+			}
+		}
+
+		// Steal from the back of whichever thread has the most tiles left
+		while (true)
+		{
+			int victim = -1;
+			int mostLeft = 0;
+			for (int i = 0; i < (int)TileQueues.size(); i++)
+			{
+				if (i == threadIndex)
+					continue;
+
+				RenderTileQueue *queue = TileQueues[i].get();
+				std::unique_lock<std::mutex> lock(queue->mutex);
+				int left = queue->back - queue->front;
+				if (left > mostLeft)
+				{
+					mostLeft = left;
+					victim = i;
+				}
+			}
+
+			if (victim == -1)
+				return false;
+
+			RenderTileQueue *queue = TileQueues[victim].get();
+			std::unique_lock<std::mutex> lock(queue->mutex);
+			if (queue->front < queue->back)
+			{
+				tile = --queue->back;
+				return true;
+			}
+			// Someone else emptied it before we got there. Look again.
+		}
+	}
+
 	void RenderScene::RenderThreadSlice(RenderThread *thread)
 	{
 		thread->FrameMemory->Clear();
@@ -298,7 +395,7 @@ namespace swrenderer
 		while (Threads.size() < (size_t)numThreads)
 		{
 			std::unique_ptr<RenderThread> thread(new RenderThread(this, false));
-			auto renderthread = thread.get();
+			int threadIndex = (int)Threads.size();
 			int start_run_id = run_id;
 			thread->thread = std::thread([=]()
 			{
@@ -313,7 +410,7 @@ namespace swrenderer
 					last_run_id = run_id;
 					start_lock.unlock();
 
-					RenderThreadSlice(renderthread);
+					RenderThreadTiles(threadIndex);
 
 					// Notify main thread that we finished:
 					std::unique_lock<std::mutex> end_lock(end_mutex);
@@ -323,6 +420,7 @@ namespace swrenderer
 				}
 			});
 			Threads.push_back(std::move(thread));
+			TileQueues.push_back(std::make_unique<RenderTileQueue>());
 		}
 	}
 
@@ -336,6 +434,7 @@ namespace swrenderer
 		{
 			Threads.back()->thread.join();
 			Threads.pop_back();
+			TileQueues.pop_back();
 		}
 		lock.lock();
 		shutdown_flag = false;
@@ -393,6 +492,15 @@ namespace swrenderer
 		FString out;
 		out.Format("frame=%04.1f ms  walls=%04.1f ms  planes=%04.1f ms  masked=%04.1f ms",
 			FrameCycles.TimeMS(), WallCycles.TimeMS(), PlaneCycles.TimeMS(), MaskedCycles.TimeMS());
+
+		// Per thread busy/idle time and tile count for the scene pass
+		double sceneMS = SceneCycles.TimeMS();
+		out.AppendFormat("\nscene=%04.1f ms  busy/idle:", sceneMS);
+		for (unsigned i = 0; i < ThreadTimings.Size(); i++)
+		{
+			double busyMS = ThreadTimings[i].BusyMS;
+			out.AppendFormat("  %u=%.1f/%.1f (%d)", i, busyMS, max(sceneMS - busyMS, 0.0), ThreadTimings[i].Tiles);
+		}
 		return out;
 	}
 
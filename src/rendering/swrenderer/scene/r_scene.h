@@ -34,9 +34,22 @@ extern cycle_t FrameCycles;
 
 namespace swrenderer
 {
-	extern cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles;
+	extern cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles, SceneCycles;
 
 	class RenderThread;
+	class RenderViewport;
+	class LightVisibility;
+
+	// Range of column tiles owned by a render thread. Other threads steal from the back once their own range is empty.
+	struct RenderTileQueue
+	{
+		std::mutex mutex;
+		int front = 0;
+		int back = 0;
+
+		cycle_t BusyCycles;
+		int TilesRendered = 0;
+	};
 	
 	class RenderScene
 	{
@@ -58,7 +71,9 @@ namespace swrenderer
 	private:
 		void RenderActorView(AActor *actor,bool renderplayersprite, bool dontmaplines);
 		void RenderThreadSlices();
+		void RenderThreadTiles(int threadIndex);
 		void RenderThreadSlice(RenderThread *thread);
+		bool NextTile(int threadIndex, int &tile);
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -75,5 +90,10 @@ namespace swrenderer
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
+
+		std::vector<std::unique_ptr<RenderTileQueue>> TileQueues;
+		int numTiles = 1;
+		std::unique_ptr<RenderViewport> TileViewport;
+		std::unique_ptr<LightVisibility> TileLight;
 	};
 }
@@ -49,6 +49,19 @@ namespace swrenderer
 		ds_source_mipmapped = tex->Mipmapped() && tex->GetPhysicalWidth() > 1 && tex->GetPhysicalHeight() > 1;
 	}
 
+	// For true color textures that are not managed by the texture manager, without mipmaps
+	void SpanDrawerArgs::SetTexture(const uint32_t *pixels, int width, int height)
+	{
+		ds_texwidth = width;
+		ds_texheight = height;
+		ds_xbits = 0;
+		ds_ybits = 0;
+		while ((2 << ds_xbits) <= width) ds_xbits++;
+		while ((2 << ds_ybits) <= height) ds_ybits++;
+		ds_source = (const uint8_t*)pixels;
+		ds_source_mipmapped = false;
+	}
+
 	void SpanDrawerArgs::SetStyle(bool masked, bool additive, fixed_t alpha, FDynamicColormap *basecolormap)
 	{
 		if (masked)
@@ -48,6 +48,7 @@
 #include "filesystem.h"
 #include "v_text.h"
 #include "m_argv.h"
+#include "stats.h"
 #include "v_video.h"
 #ifndef _MSC_VER
 #include "i_system.h"  // for strlwr()
@@ -1360,8 +1361,13 @@ void ParseAllDecorate()
 
 	while ((lump = fileSystem.FindLump("DECORATE", &lastlump)) != -1)
 	{
+		cycle_t parsetime;
+		parsetime.Reset();
+		parsetime.Clock();
 		FScanner sc(lump);
 		auto ns = Namespaces.NewNamespace(sc.LumpNum);
 		ParseDecorate(sc, ns);
+		parsetime.Unclock();
+		AddScriptTime(lump, STP_Parse, parsetime.TimeMS());
 	}
 }
@@ -423,12 +423,22 @@ void ParseScripts()
 
 	while ((lump = fileSystem.FindLump("ZSCRIPT", &lastlump)) != -1)
 	{
+		cycle_t parsetime, compiletime;
+		parsetime.Reset();
+		compiletime.Reset();
+
 		ZCCParseState state;
+		parsetime.Clock();
 		auto newns = ParseOneScript(lump, state);
+		parsetime.Unclock();
 		PSymbolTable symtable;
 
+		compiletime.Clock();
 		ZCCDoomCompiler cc(state, NULL, symtable, newns, lump, state.ParseVersion);
 		cc.Compile();
+		compiletime.Unclock();
+		AddScriptTime(lump, STP_Parse, parsetime.TimeMS());
+		AddScriptTime(lump, STP_Compile, compiletime.TimeMS());
 
 		if (FScriptPosition::ErrorCounter > 0)
 		{
@@ -40,14 +40,23 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <atomic>
+#include <thread>
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "ctpl.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Below this many seg classifications per SelectSplitter call,
+// scoring the splitters on other threads costs more than it saves.
+const unsigned int MinParallelWork = 1 << 17;
+
+static ctpl::thread_pool NodePool;
+
 #if 0
 #define D(x) x
 #else
@@ -106,6 +115,8 @@ void FNodeBuilder::Clear()
 	Planes.Clear();
 	Touched.Clear();
 	Colinear.Clear();
+	Candidates.Clear();
+	CandidateScores.Clear();
 	SplitSharers.Clear();
 	if (VertexMap == NULL)
 	{
@@ -428,7 +439,7 @@ bool FNodeBuilder::ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uin
 		node.dx = -node.dx;
 		node.dy = -node.dy;
 	}
-	return Heuristic (node, set, false) > 0;
+	return Heuristic (node, set, false, Touched, Colinear) > 0;
 }
 
 // Splitters are chosen to coincide with segs in the given set. To reduce the
@@ -438,12 +449,17 @@ bool FNodeBuilder::ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uin
 // each unique plane needs to be considered as a splitter. A result of 0 means
 // this set is a convex region. A result of -1 means that there were possible
 // splitters, but they all split segs we want to keep intact.
+//
+// Which segs get considered does not depend on any of the scores, so they are
+// collected first and scored in one go, which lets ScoreCandidates spread
+// large sets across threads. The best one is still picked in seg order.
 int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit)
 {
 	int stepleft;
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int setsize;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -451,8 +467,10 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	seg = set;
 	stepleft = 0;
+	setsize = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+	Candidates.Clear();
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
@@ -473,28 +491,34 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push(seg);
 			}
 		}
 
+		setsize++;
 		seg = pseg->next;
 	}
 
+	ScoreCandidates (set, nosplit, setsize);
+
+	for (unsigned int i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+		seg = Candidates[i];
+
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", seg, Segs[seg].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = seg;
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
+	}
+
 	if (bestseg == UINT_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
@@ -508,13 +532,61 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Fills CandidateScores with the Heuristic of each seg in Candidates. Heuristic
+// only reads the builder's state, so apart from the loop lists every thread
+// can share it.
+
+void FNodeBuilder::ScoreCandidates (uint32_t set, bool nosplit, unsigned int setsize)
+{
+	unsigned int count = Candidates.Size();
+	CandidateScores.Resize(count);
+
+	int numthreads = std::min<int>(std::thread::hardware_concurrency(), count);
+	if (numthreads < 2 || uint64_t(count) * setsize < MinParallelWork)
+	{
+		node_t node;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, nosplit, Touched, Colinear);
+		}
+		return;
+	}
+
+	if (NodePool.size() < numthreads)
+	{
+		NodePool.resize(numthreads);
+	}
+
+	std::vector<std::future<void>> jobs;
+	std::atomic<unsigned int> next = { 0 };
+	for (int i = 0; i < numthreads; i++)
+	{
+		jobs.push_back(NodePool.push([&](int threadid)
+		{
+			TArray<int> touched, colinear;
+			node_t node;
+			unsigned int index;
+			while ((index = next++) < count)
+			{
+				SetNodeFromSeg (node, &Segs[Candidates[index]]);
+				CandidateScores[index] = Heuristic (node, set, nosplit, touched, colinear);
+			}
+		}));
+	}
+	for (auto &job : jobs)
+	{
+		job.wait();
+	}
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -529,8 +601,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != UINT_MAX)
 	{
@@ -556,32 +628,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -698,8 +770,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -712,10 +784,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}